@@ -0,0 +1,3 @@
+#define BUILD_TOOLCHAIN "GCC"
+#define BUILD_COMPILER "gcc (Debian 12.2.0-14+deb12u1) 12.2.0"
+#define BUILD_FLAGS "-O3 -ffast-math -march=native -std=c99 -fopenmp -D_GNU_SOURCE -DSIZE=125000000ull -DNTIMES=100 -DARRAY_ALIGNMENT=64"
@@ -2,6 +2,9 @@
 TOOLCHAIN ?= GCC
 ENABLE_OPENMP ?= true
 ENABLE_LIKWID ?= false
+# Build GCC and ICX for the x86-64-v2 baseline instead of the build host, only
+# the ws kernel variants of type double then use the wider instruction sets
+ENABLE_PORTABLE ?= false
 
 #Feature options
 # 4GB dataset for desktop systems
@@ -10,8 +13,6 @@ OPTIONS +=  -DNTIMES=100
 # 40GB dataset for server systems
 # OPTIONS  =  -DSIZE=1250000000ull
 # OPTIONS +=  -DNTIMES=10
-# Enable to enforce AVX512 streaming stores
-#OPTIONS +=  -DAVX512_INTRINSICS
 OPTIONS +=  -DARRAY_ALIGNMENT=64
 #OPTIONS +=  -DVERBOSE_AFFINITY
 #OPTIONS +=  -DVERBOSE_DATASIZE
@@ -35,6 +35,26 @@ EOF
   fi
 done
 
+# Generate latency plot
+lat_file="./dat/Latency.dat"
+
+if [[ -f "$lat_file" ]]; then
+  echo "Plotting Latency..."
+
+  gnuplot -persist <<EOF
+set terminal pngcairo size 1200,800 enhanced font 'Arial,16'
+set output './plots/Latency.png'
+set title "Pointer chasing latency"
+set xlabel "Array Size [N]"
+set ylabel "Latency [ns]"
+set grid x,y
+set yrange [0:]
+set logscale x
+set datafile commentschars "#"
+plot '${lat_file}' using 1:3 with linespoints title "Latency" pointsize 2 pointtype 7 lw 4 lt 7
+EOF
+fi
+
 # Generate combined plot
 if [[ ${#combined_plot_commands[@]} -gt 0 ]]; then
   echo "Generating combined plot..."
@@ -12,6 +12,7 @@ VERSION  = --version
 CFLAGS   = -O3 -ffast-math -std=c99 $(OPENMP)
 #CFLAGS   = -Ofast -fnt-store=aggressive  -std=c99 $(OPENMP) #AMD CLANG
 LFLAGS   = $(OPENMP)
+LIBS    += -lm
 DEFINES  = -D_GNU_SOURCE
 INCLUDES =
 # Uncomment for homebrew libomp on MacOS
@@ -5,9 +5,17 @@ ifeq ($(ENABLE_OPENMP),true)
 OPENMP   = -fopenmp
 endif
 
+# Portable x86 baseline, the avx2 and avx512 kernel variants are compiled with
+# target attributes and selected at runtime
+ifeq ($(ENABLE_PORTABLE)-$(shell uname -m),true-x86_64)
+ARCHFLAGS = -march=x86-64-v2
+else
+ARCHFLAGS = -march=native
+endif
+
 VERSION  = --version
-CFLAGS   = -O3 -ffast-math -march=native -std=c99 $(OPENMP)
+CFLAGS   = -O3 -ffast-math $(ARCHFLAGS) -std=c99 $(OPENMP)
 LFLAGS   = $(OPENMP)
 DEFINES  = -D_GNU_SOURCE
 INCLUDES =
-LIBS     =
+LIBS     = -lm
@@ -11,9 +11,17 @@ else
 FAST_WORKAROUND = -O3 -static -fp-model=fast
 endif
 
+# Portable baseline, the avx2 and avx512 kernel variants are compiled with target
+# attributes and selected at runtime
+ifeq ($(ENABLE_PORTABLE),true)
+ARCHFLAGS = -march=x86-64-v2
+else
+ARCHFLAGS = -xHost
+endif
+
 VERSION  = --version
-CFLAGS   = $(FAST_WORKAROUND) -xHost -std=c99 -Wno-unused-command-line-argument -ffreestanding $(OPENMP)
+CFLAGS   = $(FAST_WORKAROUND) $(ARCHFLAGS) -std=c99 -Wno-unused-command-line-argument -ffreestanding $(OPENMP)
 LFLAGS   = $(OPENMP)
 DEFINES  = -D_GNU_SOURCE
 INCLUDES =
-LIBS     =
+LIBS     = -lm
@@ -6,13 +6,19 @@
 
 #ifdef _OPENMP
 
+#include <dirent.h>
+#include <omp.h>
 #include <pthread.h>
 #include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "affinity.h"
+
 #define gettid() syscall(SYS_gettid)
 
 static int getProcessorID(cpu_set_t *cpu_set)
@@ -74,5 +80,395 @@ void affinity_getmask(void)
   printf("\n");
 }
 
+/* Location of a processor in the machine, read from sysfs. smt is the index of
+ * the processor among the hardware threads of its core. */
+typedef struct {
+  int cpu;
+  int node;
+  int package;
+  int core;
+  int smt;
+} cpuInfo;
+
+static const char *_pinExpression = NULL;
+
+/* Parses a list like "0-3,8-15:2" into cpus, a range may have a stride.
+ * Returns the number of entries or -1 on a syntax error. */
+static int parseList(const char *list, int *cpus, const int max)
+{
+  const char *ptr = list;
+  int count       = 0;
+
+  while (*ptr != '\0' && *ptr != '\n') {
+    char *end;
+    long first  = strtol(ptr, &end, 10);
+    long last   = first;
+    long stride = 1;
+
+    if (end == ptr || first < 0) {
+      return -1;
+    }
+    if (*end == '-') {
+      ptr  = end + 1;
+      last = strtol(ptr, &end, 10);
+      if (end == ptr || last < first) {
+        return -1;
+      }
+    }
+    if (*end == ':') {
+      ptr    = end + 1;
+      stride = strtol(ptr, &end, 10);
+      if (end == ptr || stride < 1) {
+        return -1;
+      }
+    }
+    if (last >= CPU_SETSIZE) {
+      return -1;
+    }
+    for (long c = first; c <= last; c += stride) {
+      if (cpus != NULL && count < max) {
+        cpus[count] = (int)c;
+      }
+      count++;
+    }
+    if (*end != ',' && *end != '\0' && *end != '\n') {
+      return -1;
+    }
+    ptr = *end == ',' ? end + 1 : end;
+  }
+
+  return count;
+}
+
+static int readInt(const char *format, const int cpu, const int fallback)
+{
+  char path[128];
+  int value;
+
+  snprintf(path, sizeof(path), format, cpu);
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return fallback;
+  }
+  if (fscanf(fp, "%d", &value) != 1) {
+    value = fallback;
+  }
+  fclose(fp);
+
+  return value;
+}
+
+// NUMA node of a processor from the nodeN link in its sysfs directory
+static int readNode(const int cpu)
+{
+  char path[64];
+  struct dirent *entry;
+  int node = 0;
+
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    return 0;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, "node", 4) == 0 &&
+        sscanf(entry->d_name + 4, "%d", &node) == 1) {
+      break;
+    }
+  }
+  closedir(dir);
+
+  return node;
+}
+
+// Index of cpu among the hardware threads of its core
+static int readSmt(const int cpu)
+{
+  char path[128];
+  char line[1024];
+  int siblings[256];
+  int smt = 0;
+
+  snprintf(path,
+      sizeof(path),
+      "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+      cpu);
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return 0;
+  }
+  if (fgets(line, sizeof(line), fp) != NULL) {
+    const int count = parseList(line, siblings, 256);
+
+    for (int i = 0; i < count && i < 256; i++) {
+      smt += siblings[i] < cpu;
+    }
+  }
+  fclose(fp);
+
+  return smt;
+}
+
+static int compareCompact(const void *a, const void *b)
+{
+  const cpuInfo *x = (const cpuInfo *)a;
+  const cpuInfo *y = (const cpuInfo *)b;
+
+  if (x->node != y->node) {
+    return x->node - y->node;
+  }
+  if (x->package != y->package) {
+    return x->package - y->package;
+  }
+  if (x->core != y->core) {
+    return x->core - y->core;
+  }
+  if (x->smt != y->smt) {
+    return x->smt - y->smt;
+  }
+
+  return x->cpu - y->cpu;
+}
+
+/* Processors the process may run on in compact order: all hardware threads of
+ * a core, then the cores of a package, then the packages of a NUMA node, then
+ * the nodes */
+static int readTopology(cpuInfo *cpus)
+{
+  cpu_set_t mask;
+  int count = 0;
+
+  sched_getaffinity(0, sizeof(cpu_set_t), &mask);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &mask)) {
+      continue;
+    }
+    cpus[count].cpu = cpu;
+    cpus[count].node = readNode(cpu);
+    cpus[count].package =
+        readInt("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu, 0);
+    cpus[count].core =
+        readInt("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu, cpu);
+    cpus[count].smt = readSmt(cpu);
+    count++;
+  }
+  qsort(cpus, count, sizeof(cpuInfo), compareCompact);
+
+  return count;
+}
+
+/* Checks the syntax of a pin expression, the processors are selected after
+ * the topology is known in affinity_pinThreads */
+int affinity_parsePinExpression(const char *expr)
+{
+  int node, count;
+  char rest;
+
+  if (strcmp(expr, "compact") == 0 || strcmp(expr, "scatter") == 0 ||
+      strcmp(expr, "no-smt") == 0 ||
+      sscanf(expr, "numa:%d%c", &node, &rest) == 1 ||
+      (sscanf(expr, "numa:%d:%d%c", &node, &count, &rest) == 2 && count > 0) ||
+      parseList(expr, NULL, 0) > 0) {
+    _pinExpression = expr;
+    return 0;
+  }
+
+  return -1;
+}
+
+/* Selects the processors of the pin expression from the compact ordered
+ * topology. scatter distributes round-robin across the NUMA nodes, no-smt uses
+ * the first hardware thread of every core, numa:<n>[:<count>] the processors of
+ * node n and a list the given processors. Returns the number of processors. */
+static int selectProcessors(const cpuInfo *topo, const int numCpus, int *cpus)
+{
+  int count = 0;
+  int node, limit;
+
+  if (strcmp(_pinExpression, "compact") == 0) {
+    for (int i = 0; i < numCpus; i++) {
+      cpus[count++] = topo[i].cpu;
+    }
+  } else if (strcmp(_pinExpression, "no-smt") == 0) {
+    for (int i = 0; i < numCpus; i++) {
+      if (topo[i].smt == 0) {
+        cpus[count++] = topo[i].cpu;
+      }
+    }
+  } else if (strcmp(_pinExpression, "scatter") == 0) {
+    int *used   = (int *)calloc(numCpus, sizeof(int));
+    int maxNode = 0;
+
+    for (int i = 0; i < numCpus; i++) {
+      maxNode = topo[i].node > maxNode ? topo[i].node : maxNode;
+    }
+    while (count < numCpus) {
+      for (int n = 0; n <= maxNode; n++) {
+        for (int i = 0; i < numCpus; i++) {
+          if (!used[i] && topo[i].node == n) {
+            used[i]       = 1;
+            cpus[count++] = topo[i].cpu;
+            break;
+          }
+        }
+      }
+    }
+    free(used);
+  } else if (sscanf(_pinExpression, "numa:%d", &node) == 1) {
+    if (sscanf(_pinExpression, "numa:%d:%d", &node, &limit) != 2) {
+      limit = numCpus;
+    }
+    for (int i = 0; i < numCpus && count < limit; i++) {
+      if (topo[i].node == node) {
+        cpus[count++] = topo[i].cpu;
+      }
+    }
+  } else {
+    count = parseList(_pinExpression, cpus, CPU_SETSIZE);
+    count = count < CPU_SETSIZE ? count : CPU_SETSIZE;
+
+    // Processors outside of the affinity mask of the process are skipped
+    int allowed = 0;
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < numCpus; j++) {
+        if (topo[j].cpu == cpus[i]) {
+          cpus[allowed++] = cpus[i];
+          break;
+        }
+      }
+    }
+    if (allowed < count) {
+      printf("Warning: %d processors of %s are not available\n",
+          count - allowed,
+          _pinExpression);
+    }
+    count = allowed;
+  }
+
+  return count;
+}
+
+// Processors selected by the pin expression, thread i runs on _pinCpus[i]
+static int *_pinCpus = NULL;
+static int _pinCount = 0;
+
+/* Pins the calling thread of the current team to its processor and verifies
+ * the placement. Returns 0 on success. */
+int affinity_pinTeam(void)
+{
+  if (_pinCount == 0) {
+    return 0;
+  }
+
+  const int cpu = _pinCpus[omp_get_thread_num() % _pinCount];
+  cpu_set_t mask;
+
+  CPU_ZERO(&mask);
+  CPU_SET(cpu, &mask);
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &mask) != 0 ||
+      sched_getaffinity(0, sizeof(cpu_set_t), &mask) != 0 || CPU_COUNT(&mask) != 1 ||
+      !CPU_ISSET(cpu, &mask) || sched_getcpu() != cpu) {
+    return -1;
+  }
+
+  return 0;
+}
+
+int affinity_getPinCount(void)
+{
+  return _pinCount;
+}
+
+// Pin expression of the run, "none" without internal pinning
+const char *affinity_getPinExpression(void)
+{
+  return _pinExpression != NULL ? _pinExpression : "none";
+}
+
+/* Pins every OpenMP thread to one processor of the pin expression given with
+ * -p. Without OMP_NUM_THREADS the number of threads is set to the number of
+ * processors. The placement is verified by every thread after pinning. */
+void affinity_pinThreads(void)
+{
+  cpuInfo *topo = (cpuInfo *)malloc(CPU_SETSIZE * sizeof(cpuInfo));
+  int failed    = 0;
+
+  if (_pinExpression == NULL) {
+    free(topo);
+    return;
+  }
+
+  const int numCpus = readTopology(topo);
+  _pinCpus          = (int *)malloc(CPU_SETSIZE * sizeof(int));
+  _pinCount         = selectProcessors(topo, numCpus, _pinCpus);
+  free(topo);
+
+  if (_pinCount == 0) {
+    fprintf(stderr, "Error: Pin expression %s selects no processors\n", _pinExpression);
+    exit(EXIT_FAILURE);
+  }
+  if (getenv("OMP_NUM_THREADS") == NULL) {
+    omp_set_num_threads(_pinCount);
+  }
+
+#pragma omp parallel reduction(+ : failed)
+  {
+    failed += affinity_pinTeam() != 0;
+
+#pragma omp single
+    {
+      const int threads = omp_get_num_threads();
+
+      printf("Pinning %d threads with %s:", threads, _pinExpression);
+      for (int t = 0; t < threads && t < 64; t++) {
+        printf(" %d->%d", t, _pinCpus[t % _pinCount]);
+      }
+      printf(threads > 64 ? " ...\n" : "\n");
+      if (threads > _pinCount) {
+        printf("Warning: More threads than processors, %d threads share a processor\n",
+            threads - _pinCount);
+      }
+    }
+  }
+
+  if (failed > 0) {
+    printf("Warning: Pinning failed for %d threads\n", failed);
+  }
+}
+
 #endif /*_OPENMP*/
 #endif /*__linux__*/
+
+#if !defined(__linux__) || !defined(_OPENMP)
+#include <stdio.h>
+
+static const char *_pinExpression = NULL;
+
+int affinity_parsePinExpression(const char *expr)
+{
+  _pinExpression = expr;
+  return 0;
+}
+
+void affinity_pinThreads(void)
+{
+  if (_pinExpression != NULL) {
+    printf("Warning: Internal pinning requires Linux and OpenMP\n");
+  }
+}
+
+int affinity_pinTeam(void)
+{
+  return 0;
+}
+
+int affinity_getPinCount(void)
+{
+  return 0;
+}
+
+const char *affinity_getPinExpression(void)
+{
+  return "none";
+}
+#endif
@@ -14,4 +14,10 @@ extern void affinity_getmask(void);
 
 #endif /*_OPENMP*/
 
+extern int affinity_parsePinExpression(const char *expr);
+extern void affinity_pinThreads(void);
+extern int affinity_pinTeam(void);
+extern int affinity_getPinCount(void);
+extern const char *affinity_getPinExpression(void);
+
 #endif /*AFFINITY_H*/
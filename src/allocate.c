@@ -5,13 +5,105 @@
 #include <errno.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "allocate.h"
+#include "cli.h"
+#include "util.h"
 
-void *allocate(const size_t alignment, const size_t bytesize)
+#ifdef __linux__
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+#define THP_SIZE (2ull << 20)
+
+static const char *pageNames[NUMPAGETYPES] = {
+  "default",
+  "4k",
+  "thp",
+  "2M",
+  "1G",
+};
+
+int parsePageType(const char *arg)
+{
+  for (int i = 0; i < NUMPAGETYPES; i++) {
+    if (strcmp(arg, pageNames[i]) == 0) {
+      page_type = i;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+static size_t hugePageSize(void)
+{
+  return page_type == PAGES_1G ? (1ull << 30) : (2ull << 20);
+}
+
+static size_t mappedSize(const size_t bytesize)
+{
+  const size_t pagesize = hugePageSize();
+  return (bytesize + pagesize - 1) & ~(pagesize - 1);
+}
+
+#ifdef __linux__
+static void *allocateHugetlb(const size_t bytesize)
+{
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                    (page_type == PAGES_1G ? MAP_HUGE_1GB : MAP_HUGE_2MB);
+  void *ptr = mmap(NULL, mappedSize(bytesize), PROT_READ | PROT_WRITE, flags, -1, 0);
+
+  if (ptr == MAP_FAILED) {
+    fprintf(stderr,
+        "Error: Failed to map %s huge pages (%s), check "
+        "/sys/kernel/mm/hugepages/*/nr_hugepages\n",
+        pageNames[page_type],
+        strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  return ptr;
+}
+
+/* madvise requires a page aligned start address */
+static void adviseRange(void *ptr, const size_t bytesize, const int advice)
+{
+  const size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t start    = (size_t)ptr & ~(pagesize - 1);
+
+  if (madvise((void *)start, (size_t)ptr + bytesize - start, advice) != 0) {
+    fprintf(stderr, "Warning: madvise failed (%s)\n", strerror(errno));
+  }
+}
+#endif
+
+void *allocate(size_t alignment, const size_t bytesize)
 {
   void *ptr;
 
+#ifdef __linux__
+  if (page_type == PAGES_2M || page_type == PAGES_1G) {
+    return allocateHugetlb(bytesize);
+  }
+#endif
+
+  if (page_type == PAGES_THP) {
+    alignment = MAX(alignment, THP_SIZE);
+  }
+
   const int errorCode = posix_memalign(&ptr, alignment, bytesize);
 
   if (errorCode) {
@@ -30,5 +122,89 @@ void *allocate(const size_t alignment, const size_t bytesize)
     exit(EXIT_FAILURE);
   }
 
+#ifdef __linux__
+  if (page_type == PAGES_THP) {
+    adviseRange(ptr, bytesize, MADV_HUGEPAGE);
+  } else if (page_type == PAGES_4K) {
+    adviseRange(ptr, bytesize, MADV_NOHUGEPAGE);
+  }
+#endif
+
   return ptr;
 }
+
+void deallocate(void *ptr, const size_t bytesize)
+{
+#ifdef __linux__
+  if (page_type == PAGES_2M || page_type == PAGES_1G) {
+    munmap(ptr, mappedSize(bytesize));
+    return;
+  }
+#endif
+
+  free(ptr);
+}
+
+/* Size of the range allocate reserves for bytesize, the huge page mappings are
+ * rounded up to whole pages. Calls operating on the mapping, such as mbind,
+ * need this size. */
+size_t allocatedSize(const size_t bytesize)
+{
+  if (page_type == PAGES_2M || page_type == PAGES_1G) {
+    return mappedSize(bytesize);
+  }
+
+  return bytesize;
+}
+
+void printPageInfo(const char *label, const void *ptr)
+{
+#ifdef __linux__
+  FILE *fp = fopen("/proc/self/smaps", "r");
+  char line[256];
+  int found             = 0;
+  size_t rss            = 0;
+  size_t kernelPageSize = 0;
+  size_t anonHugePages  = 0;
+
+  if (fp == NULL) {
+    printf("%s: page size not available\n", label);
+    return;
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    unsigned long start, end;
+
+    /* A mapping header line starts with the address range */
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      if (found) {
+        break;
+      }
+      found = (size_t)ptr >= start && (size_t)ptr < end;
+      continue;
+    }
+    if (found) {
+      sscanf(line, "Rss: %zu kB", &rss);
+      sscanf(line, "KernelPageSize: %zu kB", &kernelPageSize);
+      sscanf(line, "AnonHugePages: %zu kB", &anonHugePages);
+    }
+  }
+  fclose(fp);
+
+  if (kernelPageSize * 1024 > (size_t)sysconf(_SC_PAGESIZE)) {
+    printf("%s: %zu kB hugetlb pages\n", label, kernelPageSize);
+  } else {
+    printf("%s: %zu kB pages, %5.1f%% of resident memory on transparent huge pages\n",
+        label,
+        kernelPageSize,
+        rss ? 100.0 * anonHugePages / rss : 0.0);
+  }
+#else
+  printf("%s: page size not available\n", label);
+#endif
+}
+
+void printPageType(void)
+{
+  printf("Requested pages: %s\n", pageNames[page_type]);
+}
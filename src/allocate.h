@@ -6,6 +6,20 @@
 #define __ALLOCATE_H_
 #include <stdlib.h>
 
+typedef enum {
+  PAGES_DEFAULT = 0,
+  PAGES_4K,
+  PAGES_THP,
+  PAGES_2M,
+  PAGES_1G,
+  NUMPAGETYPES
+} pagetypes;
+
+extern int parsePageType(const char *arg);
 extern void *allocate(size_t alignment, size_t bytesize);
+extern void deallocate(void *ptr, size_t bytesize);
+extern size_t allocatedSize(size_t bytesize);
+extern void printPageType(void);
+extern void printPageInfo(const char *label, const void *ptr);
 
 #endif
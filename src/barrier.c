@@ -0,0 +1,46 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <sched.h>
+
+#include "barrier.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SPIN_PAUSE() __builtin_ia32_pause()
+#else
+#define SPIN_PAUSE()
+#endif
+
+/* Spins after which a waiting thread yields its core, this only matters if
+ * there are more threads than cores */
+#define SPIN_YIELD 100000
+
+void barrier_init(spinBarrier *barrier, const int threads)
+{
+  barrier->count   = threads;
+  barrier->threads = threads;
+  barrier->sense   = 0;
+}
+
+/* The last thread to arrive resets the counter and releases the others by
+ * flipping the sense. The release and acquire order makes all stores before
+ * the barrier visible to the threads after it. */
+void barrier_wait(spinBarrier *barrier, int *sense)
+{
+  *sense = !*sense;
+
+  if (__atomic_sub_fetch(&barrier->count, 1, __ATOMIC_ACQ_REL) == 0) {
+    __atomic_store_n(&barrier->count, barrier->threads, __ATOMIC_RELAXED);
+    __atomic_store_n(&barrier->sense, *sense, __ATOMIC_RELEASE);
+    return;
+  }
+
+  for (long spins = 1; __atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE) != *sense;
+       spins++) {
+    SPIN_PAUSE();
+    if (spins % SPIN_YIELD == 0) {
+      sched_yield();
+    }
+  }
+}
@@ -0,0 +1,23 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include "kernels.h"
+
+/* Sense-reversing spin barrier for the threads of a parallel region. The
+ * counter and the sense are on separate cache lines, the waiting threads only
+ * read the sense. Every thread keeps its own sense, initialized to 0. */
+typedef struct {
+  int count;
+  int threads;
+  char pad[CACHELINE_SIZE - 2 * sizeof(int)];
+  int sense;
+} spinBarrier;
+
+extern void barrier_init(spinBarrier *barrier, int threads);
+extern void barrier_wait(spinBarrier *barrier, int *sense);
+
+#endif /*BARRIER_H*/
@@ -0,0 +1,286 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "baseline.h"
+#include "cli.h"
+
+#define MAXLINE 4096
+#define MAXFIELDS 64
+
+/* Mean bandwidth and half-width of its confidence interval of a kernel in
+ * the baseline, both in GB/s */
+typedef struct {
+  char kernel[32];
+  size_t N;
+  double rate;
+  double ci;
+} baselineEntry;
+
+static baselineEntry *_entries = NULL;
+static int _numEntries         = 0;
+static int _verdict            = VERDICT_PASS;
+static const char *verdictNames[] = { "pass", "warn", "fail" };
+
+static void addEntry(
+    const char *kernel, const size_t N, const double rate, const double ci)
+{
+  _entries = (baselineEntry *)realloc(
+      _entries, (_numEntries + 1) * sizeof(baselineEntry));
+  baselineEntry *e = &_entries[_numEntries++];
+
+  snprintf(e->kernel, sizeof(e->kernel), "%s", kernel);
+  e->N    = N;
+  e->rate = rate;
+  e->ci   = ci;
+}
+
+/* The rate in the result files is based on the minimum time, the comparison
+ * uses the mean bandwidth the confidence interval belongs to */
+static double meanRate(const double rate, const double min, const double avg)
+{
+  return avg > 0.0 ? rate * min / avg : rate;
+}
+
+/* Value of "key" in the JSON object record, whitespace around the colon is
+ * allowed */
+static const char *jsonValue(const char *record, const char *key)
+{
+  char pattern[64];
+  const char *p;
+
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+  if ((p = strstr(record, pattern)) == NULL) {
+    return NULL;
+  }
+  p += strlen(pattern);
+  p += strspn(p, " \t\r\n");
+  if (*p != ':') {
+    return NULL;
+  }
+  return p + 1 + strspn(p + 1, " \t\r\n");
+}
+
+static char *readFile(FILE *file)
+{
+  size_t size = 0;
+  size_t len  = 0;
+  char *text  = NULL;
+
+  do {
+    size = size ? 2 * size : MAXLINE;
+    text = (char *)realloc(text, size);
+    len += fread(text + len, 1, size - 1 - len, file);
+  } while (len == size - 1);
+  text[len] = '\0';
+
+  return text;
+}
+
+/* Adds the records of the "results" array, each a flat object with the keys
+ * kernel, N, rate_gbs, min_s, avg_s and ci_gbs. The layout of the file does not
+ * matter. */
+static int loadJson(FILE *file)
+{
+  char *text    = readFile(file);
+  const char *p = strstr(text, "\"results\"");
+  char kernel[32];
+
+  if (p == NULL) {
+    free(text);
+    return -1;
+  }
+
+  while ((p = strchr(p, '{')) != NULL) {
+    char *record = (char *)p;
+    char *close  = strchr(record, '}');
+
+    if (close == NULL) {
+      break;
+    }
+    *close = '\0';
+
+    const char *k    = jsonValue(record, "kernel");
+    const char *n    = jsonValue(record, "N");
+    const char *rate = jsonValue(record, "rate_gbs");
+    const char *min  = jsonValue(record, "min_s");
+    const char *avg  = jsonValue(record, "avg_s");
+    const char *ci   = jsonValue(record, "ci_gbs");
+
+    if (k != NULL && n != NULL && rate != NULL && min != NULL && avg != NULL &&
+        ci != NULL && sscanf(k, "\"%31[^\"]\"", kernel) == 1) {
+      addEntry(kernel,
+          strtoull(n, NULL, 10),
+          meanRate(atof(rate), atof(min), atof(avg)),
+          atof(ci));
+    }
+    p = close + 1;
+  }
+  free(text);
+
+  return 0;
+}
+
+/* Splits a CSV line into its fields in place, quotes are removed. Returns the
+ * number of fields. */
+static int splitCsv(char *line, char **fields)
+{
+  int count = 0;
+  char *out = line;
+  int quoted = 0;
+
+  fields[count++] = out;
+  for (char *c = line; *c != '\0' && *c != '\n'; c++) {
+    if (*c == '"') {
+      if (quoted && c[1] == '"') {
+        *out++ = *c++;
+      } else {
+        quoted = !quoted;
+      }
+    } else if (*c == ',' && !quoted && count < MAXFIELDS) {
+      *out++          = '\0';
+      fields[count++] = out;
+    } else {
+      *out++ = *c;
+    }
+  }
+  *out = '\0';
+
+  return count;
+}
+
+static int findColumn(char **fields, const int count, const char *name)
+{
+  for (int i = 0; i < count; i++) {
+    if (strcmp(fields[i], name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static int loadCsv(FILE *file)
+{
+  char line[MAXLINE];
+  char *fields[MAXFIELDS];
+
+  if (fgets(line, sizeof(line), file) == NULL) {
+    return -1;
+  }
+
+  const int count = splitCsv(line, fields);
+  const int k     = findColumn(fields, count, "kernel");
+  const int n     = findColumn(fields, count, "N");
+  const int rate  = findColumn(fields, count, "rate_gbs");
+  const int min   = findColumn(fields, count, "min_s");
+  const int avg   = findColumn(fields, count, "avg_s");
+  const int ci    = findColumn(fields, count, "ci_gbs");
+
+  if (k < 0 || n < 0 || rate < 0 || min < 0 || avg < 0 || ci < 0) {
+    return -1;
+  }
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (splitCsv(line, fields) != count) {
+      continue;
+    }
+    addEntry(fields[k],
+        strtoull(fields[n], NULL, 10),
+        meanRate(atof(fields[rate]), atof(fields[min]), atof(fields[avg])),
+        atof(fields[ci]));
+  }
+
+  return 0;
+}
+
+/* Loads a result file written with --output, the format is detected from the
+ * first non-blank character. Returns -1 if the file cannot be read. */
+int baseline_load(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  int first;
+  int ret;
+
+  if (file == NULL) {
+    return -1;
+  }
+
+  do {
+    first = fgetc(file);
+  } while (isspace(first));
+  ungetc(first, file);
+  ret = first == '{' ? loadJson(file) : loadCsv(file);
+  fclose(file);
+
+  return ret == 0 && _numEntries > 0 ? 0 : -1;
+}
+
+int baseline_isLoaded(void)
+{
+  return _numEntries > 0;
+}
+
+void baseline_printHeader(void)
+{
+  printf("Function      Rate(GB/s)  Base(GB/s)  Change(%%)  Verdict\n");
+}
+
+/* Compares the mean bandwidth rate with confidence interval ci of kernel to
+ * the baseline. A drop larger than the combined confidence intervals is
+ * significant. It fails if it also exceeds the tolerance, a significant drop
+ * within the tolerance or a drop beyond the tolerance which is not significant
+ * due to noise is a warning. */
+int baseline_compare(
+    const char *kernel, const size_t N, const double rate, const double ci)
+{
+  const baselineEntry *e = NULL;
+
+  for (int i = 0; i < _numEntries; i++) {
+    // Prefer the entry with the same N if the baseline is a sweep
+    if (strcasecmp(_entries[i].kernel, kernel) == 0 &&
+        (e == NULL || _entries[i].N == N)) {
+      e = &_entries[i];
+    }
+  }
+
+  if (e == NULL) {
+    printf("%-12s%11.2f %11s %9s    no baseline\n", kernel, rate, "-", "-");
+    return VERDICT_PASS;
+  }
+
+  const double change      = 100.0 * (rate - e->rate) / e->rate;
+  const double uncertainty = sqrt(ci * ci + e->ci * e->ci);
+  const int significant    = e->rate - rate > uncertainty;
+  const int large          = -change > tolerance;
+  int verdict              = VERDICT_PASS;
+
+  if (significant && large) {
+    verdict = VERDICT_FAIL;
+  } else if (significant || large) {
+    verdict = VERDICT_WARN;
+  }
+
+  printf("%-12s%11.2f %11.2f %9.2f    %s%s\n",
+      kernel,
+      rate,
+      e->rate,
+      change,
+      verdictNames[verdict],
+      e->N != N ? " (different N)" : "");
+
+  _verdict = verdict > _verdict ? verdict : _verdict;
+  return verdict;
+}
+
+int baseline_getVerdict(void)
+{
+  return _verdict;
+}
@@ -0,0 +1,20 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef BASELINE_H
+#define BASELINE_H
+#include <stddef.h>
+
+typedef enum { VERDICT_PASS = 0, VERDICT_WARN, VERDICT_FAIL } verdicts;
+
+// Exit code of a run with at least one failed kernel
+#define BASELINE_EXIT_REGRESSION 2
+
+extern int baseline_load(const char *path);
+extern int baseline_isLoaded(void);
+extern void baseline_printHeader(void);
+extern int baseline_compare(const char *kernel, size_t N, double rate, double ci);
+extern int baseline_getVerdict(void);
+
+#endif /*BASELINE_H*/
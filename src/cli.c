@@ -1,29 +1,130 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <getopt.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "affinity.h"
+#include "allocate.h"
+#include "baseline.h"
 #include "cli.h"
+#include "indices.h"
+#include "isa.h"
+#include "numa.h"
+#include "output.h"
+#include "profiler.h"
+#include "registry.h"
+#include "streams.h"
 
 int CUDA_DEVICE    = 0;
 int type           = WS;
 int SEQ            = 0;
 int data_init_type = 0;
+int load_kernel    = -1;
+int kernel_isa     = ISA_AUTO;
+int placement      = FIRSTTOUCH;
+int placement_node = 0;
+int page_type      = PAGES_DEFAULT;
+int store_mode     = STORES_REGULAR;
+int data_type      = DT_DOUBLE;
+int index_type     = SEQUENTIAL;
 size_t N           = 125000000ull;
 size_t ITERS       = 10;
+size_t STRIDE      = 8;
+size_t index_block = INDEX_BLOCKSIZE;
+double ci_target   = 0.0;
+double time_budget = 60.0;
+double sweep_time  = 0.5;
+int private_inputs = 0;
+int output_format  = OUTPUT_TEXT;
+double tolerance   = 5.0;
+int persistent     = 0;
+int scaling_step   = 1;
+int perf_counters  = 0;
+
+// Grid of the stencil kernels, 0 selects the default
+size_t stencil_inner = 0;
+size_t stencil_block = 0;
+
+// Arrays of the N-stream kernel
+int stream_reads  = STREAMS_READS;
+int stream_writes = STREAMS_WRITES;
+
+// Software prefetch of copy, triad and sum, a distance of 0 disables it
+size_t prefetch_distance = 0;
+int prefetch_hint        = PREFETCH_T0;
+int prefetch_sweep       = 0;
+
+const char *dataTypeNames[NUMDATATYPES]   = { "double", "float", "int32", "int64" };
+const char *storeModeNames[NUMSTOREMODES] = { "regular", "nt", "auto" };
+const size_t dataTypeSizes[NUMDATATYPES]  = { sizeof(double),
+  sizeof(float),
+  sizeof(int32_t),
+  sizeof(int64_t) };
+
+const char *prefetchHintNames[NUMPREFETCHHINTS] = { "t0", "nta" };
+
+// Long only options use values outside of the character range
+#define OPT_STORES 256
+#define OPT_DATATYPE 257
+#define OPT_STRIDE 258
+#define OPT_INDEX 259
+#define OPT_CI 260
+#define OPT_BUDGET 261
+#define OPT_SWEEPTIME 262
+#define OPT_PRIVATE 263
+#define OPT_OUTPUT 264
+#define OPT_BASELINE 265
+#define OPT_TOLERANCE 266
+#define OPT_TRACE 267
+#define OPT_PERSISTENT 268
+#define OPT_STEP 269
+#define OPT_COUNTERS 270
+#define OPT_STENCIL 271
+#define OPT_STREAMS 272
+#define OPT_PREFETCH 273
+
+// Maximum number of runs with --ci if no -n is given
+#define ADAPTIVE_MAXITERS 1000
+
+static const struct option longOptions[] = {
+  { "stores",     required_argument, NULL, OPT_STORES     },
+  { "datatype",   required_argument, NULL, OPT_DATATYPE   },
+  { "stride",     required_argument, NULL, OPT_STRIDE     },
+  { "index",      required_argument, NULL, OPT_INDEX      },
+  { "ci",         required_argument, NULL, OPT_CI         },
+  { "budget",     required_argument, NULL, OPT_BUDGET     },
+  { "sweep-time", required_argument, NULL, OPT_SWEEPTIME  },
+  { "private",    no_argument,       NULL, OPT_PRIVATE    },
+  { "output",     required_argument, NULL, OPT_OUTPUT     },
+  { "baseline",   required_argument, NULL, OPT_BASELINE   },
+  { "tolerance",  required_argument, NULL, OPT_TOLERANCE  },
+  { "trace",      required_argument, NULL, OPT_TRACE      },
+  { "persistent", no_argument,       NULL, OPT_PERSISTENT },
+  { "step",       required_argument, NULL, OPT_STEP       },
+  { "counters",   no_argument,       NULL, OPT_COUNTERS   },
+  { "stencil",    required_argument, NULL, OPT_STENCIL    },
+  { "streams",    required_argument, NULL, OPT_STREAMS    },
+  { "prefetch",   required_argument, NULL, OPT_PREFETCH   },
+  { NULL,         0,                 NULL, 0              }
+};
 
 void parseCLI(int argc, char **argv)
 {
   int co;
-  opterr = 0;
+  int itersGiven = 0;
+  int pinGiven   = 0;
+  opterr         = 0;
 
-  while ((co = getopt(argc, argv, "hm:s:n:i:d:")) != -1)
+  while ((co = getopt_long(
+               argc, argv, "hm:l:k:s:n:i:a:p:P:H:d:", longOptions, NULL)) != -1)
     switch (co) {
     case 'h': {
       printf(HELPTEXT);
@@ -40,6 +141,12 @@ void parseCLI(int argc, char **argv)
       } else if (strcmp(optarg, "seq") == 0) {
         type = SQ;
         SEQ  = 1;
+      } else if (strcmp(optarg, "loaded") == 0) {
+        type = LOADED;
+        SEQ  = 0;
+      } else if (strcmp(optarg, "scaling") == 0) {
+        type = SCALING;
+        SEQ  = 0;
       } else {
         printf("Unknown bench type %s\n", optarg);
         exit(1);
@@ -47,6 +154,25 @@ void parseCLI(int argc, char **argv)
       break;
     }
 
+    case 'l': {
+      if (strcmp(optarg, "triad") == 0 || strcmp(optarg, "copy") == 0 ||
+          strcmp(optarg, "sum") == 0) {
+        load_kernel = registry_find(optarg);
+      } else {
+        printf("Invalid load kernel %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
+    case 'k': {
+      if (registry_select(optarg) != 0) {
+        fprintf(stderr, "Invalid kernel selection %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
     case 's': {
       char *end;
       errno = 0;
@@ -66,6 +192,7 @@ void parseCLI(int argc, char **argv)
         fprintf(stderr, "Invalid numeric value for -n: %s\n", optarg);
         exit(1);
       }
+      itersGiven = 1;
       break;
     }
 
@@ -81,6 +208,231 @@ void parseCLI(int argc, char **argv)
       break;
     }
 
+    case 'a': {
+      const int val = isa_parse(optarg);
+      if (val == NUMISAS) {
+        fprintf(stderr, "Invalid kernel variant %s\n", optarg);
+        exit(1);
+      }
+      kernel_isa = val;
+      break;
+    }
+
+    case 'p': {
+      if (affinity_parsePinExpression(optarg) != 0) {
+        fprintf(stderr, "Invalid pin expression %s\n", optarg);
+        exit(1);
+      }
+      pinGiven = 1;
+      break;
+    }
+
+    case 'P': {
+      if (numa_parsePlacement(optarg) != 0) {
+        fprintf(stderr, "Invalid placement policy %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
+    case 'H': {
+      if (parsePageType(optarg) != 0) {
+        fprintf(stderr, "Invalid page type %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
+    case OPT_STORES: {
+      if (strcmp(optarg, "regular") == 0)
+        store_mode = STORES_REGULAR;
+      else if (strcmp(optarg, "nt") == 0) {
+        store_mode = STORES_NT;
+      } else if (strcmp(optarg, "auto") == 0) {
+        store_mode = STORES_AUTO;
+      } else {
+        fprintf(stderr, "Invalid store mode %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
+    case OPT_DATATYPE: {
+      int val = NUMDATATYPES;
+      for (int i = 0; i < NUMDATATYPES; i++) {
+        if (strcmp(optarg, dataTypeNames[i]) == 0) {
+          val = i;
+        }
+      }
+      if (val == NUMDATATYPES) {
+        fprintf(stderr, "Invalid data type %s\n", optarg);
+        exit(1);
+      }
+      data_type = val;
+      break;
+    }
+
+    case OPT_STRIDE: {
+      char *end;
+      errno          = 0;
+      const long val = strtol(optarg, &end, 10);
+      if (*end != '\0' || errno != 0 || val < 1) {
+        fprintf(stderr, "Invalid stride: %s\n", optarg);
+        exit(1);
+      }
+      STRIDE = (size_t)val;
+      registry_select("Stride");
+      break;
+    }
+
+    case OPT_INDEX: {
+      if (index_parseType(optarg) != 0) {
+        fprintf(stderr, "Invalid index type %s\n", optarg);
+        exit(1);
+      }
+      registry_select("Gather,Scatter");
+      break;
+    }
+
+    case OPT_CI: {
+      char *end;
+      errno            = 0;
+      const double val = strtod(optarg, &end);
+      if (*end != '\0' || errno != 0 || val <= 0.0) {
+        fprintf(stderr, "Invalid confidence interval: %s\n", optarg);
+        exit(1);
+      }
+      ci_target = val;
+      break;
+    }
+
+    case OPT_BUDGET: {
+      char *end;
+      errno            = 0;
+      const double val = strtod(optarg, &end);
+      if (*end != '\0' || errno != 0 || val <= 0.0) {
+        fprintf(stderr, "Invalid time budget: %s\n", optarg);
+        exit(1);
+      }
+      time_budget = val;
+      break;
+    }
+
+    case OPT_SWEEPTIME: {
+      char *end;
+      errno            = 0;
+      const double val = strtod(optarg, &end);
+      if (*end != '\0' || errno != 0 || val <= 0.0) {
+        fprintf(stderr, "Invalid sweep time: %s\n", optarg);
+        exit(1);
+      }
+      sweep_time = val;
+      break;
+    }
+
+    case OPT_PRIVATE: {
+      private_inputs = 1;
+      break;
+    }
+
+    case OPT_OUTPUT: {
+      if (output_parseFormat(optarg) != 0) {
+        fprintf(stderr, "Invalid output format %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
+    case OPT_BASELINE: {
+      if (baseline_load(optarg) != 0) {
+        fprintf(stderr, "Cannot read baseline results from %s\n", optarg);
+        exit(1);
+      }
+      break;
+    }
+
+    case OPT_TOLERANCE: {
+      char *end;
+      errno            = 0;
+      const double val = strtod(optarg, &end);
+      if (*end != '\0' || errno != 0 || val < 0.0) {
+        fprintf(stderr, "Invalid tolerance: %s\n", optarg);
+        exit(1);
+      }
+      tolerance = val;
+      break;
+    }
+
+    case OPT_TRACE: {
+      profilerSetTrace(optarg);
+      break;
+    }
+
+    case OPT_PERSISTENT: {
+      persistent = 1;
+      break;
+    }
+
+    case OPT_STEP: {
+      char *end;
+      errno          = 0;
+      const long val = strtol(optarg, &end, 10);
+      if (*end != '\0' || errno != 0 || val < 1 || val > INT_MAX) {
+        fprintf(stderr, "Invalid thread stepping: %s\n", optarg);
+        exit(1);
+      }
+      scaling_step = (int)val;
+      break;
+    }
+
+    case OPT_COUNTERS:
+      perf_counters = 1;
+      break;
+
+    case OPT_STENCIL: {
+      char *end;
+      errno          = 0;
+      const long val = strtol(optarg, &end, 10);
+      long block     = 0;
+      if (*end == ':') {
+        block = strtol(end + 1, &end, 10);
+      }
+      if (*end != '\0' || errno != 0 || val < 0 || block < 0) {
+        fprintf(stderr, "Invalid stencil grid: %s\n", optarg);
+        exit(1);
+      }
+      stencil_inner = (size_t)val;
+      stencil_block = (size_t)block;
+      registry_select("Stencil2D,Stencil3D");
+      break;
+    }
+
+    case OPT_STREAMS: {
+      if (streams_parse(optarg) != 0) {
+        fprintf(stderr, "Invalid stream counts: %s\n", optarg);
+        exit(1);
+      }
+      registry_select("Streams");
+      break;
+    }
+
+    case OPT_PREFETCH: {
+      char *end        = optarg + 4;
+      errno            = 0;
+      const int sweep  = strncmp(optarg, "auto", 4) == 0;
+      const long val   = sweep ? 0 : strtol(optarg, &end, 10);
+      const char *hint = *end == ':' ? end + 1 : "t0";
+      if (end == optarg || (*end != '\0' && *end != ':') || errno != 0 || val < 0 ||
+          (strcmp(hint, "t0") != 0 && strcmp(hint, "nta") != 0)) {
+        fprintf(stderr, "Invalid prefetch distance: %s\n", optarg);
+        exit(1);
+      }
+      prefetch_sweep    = sweep;
+      prefetch_distance = (size_t)val;
+      prefetch_hint     = strcmp(hint, "nta") == 0 ? PREFETCH_NTA : PREFETCH_T0;
+      break;
+    }
+
     case 'd': {
       char *end;
       errno          = 0;
@@ -97,7 +449,39 @@ void parseCLI(int argc, char **argv)
     }
 
     case '?': {
-      if (optopt == 'c')
+      if (optopt == OPT_STORES)
+        fprintf(stderr, "Option --stores requires an argument.\n");
+      else if (optopt == OPT_DATATYPE)
+        fprintf(stderr, "Option --datatype requires an argument.\n");
+      else if (optopt == OPT_STRIDE)
+        fprintf(stderr, "Option --stride requires an argument.\n");
+      else if (optopt == OPT_INDEX)
+        fprintf(stderr, "Option --index requires an argument.\n");
+      else if (optopt == OPT_CI)
+        fprintf(stderr, "Option --ci requires an argument.\n");
+      else if (optopt == OPT_BUDGET)
+        fprintf(stderr, "Option --budget requires an argument.\n");
+      else if (optopt == OPT_SWEEPTIME)
+        fprintf(stderr, "Option --sweep-time requires an argument.\n");
+      else if (optopt == OPT_OUTPUT)
+        fprintf(stderr, "Option --output requires an argument.\n");
+      else if (optopt == OPT_BASELINE)
+        fprintf(stderr, "Option --baseline requires an argument.\n");
+      else if (optopt == OPT_TOLERANCE)
+        fprintf(stderr, "Option --tolerance requires an argument.\n");
+      else if (optopt == OPT_TRACE)
+        fprintf(stderr, "Option --trace requires an argument.\n");
+      else if (optopt == OPT_STEP)
+        fprintf(stderr, "Option --step requires an argument.\n");
+      else if (optopt == OPT_STENCIL)
+        fprintf(stderr, "Option --stencil requires an argument.\n");
+      else if (optopt == OPT_STREAMS)
+        fprintf(stderr, "Option --streams requires an argument.\n");
+      else if (optopt == OPT_PREFETCH)
+        fprintf(stderr, "Option --prefetch requires an argument.\n");
+      else if (optopt == 0)
+        fprintf(stderr, "Unknown option `%s'.\n", argv[optind - 1]);
+      else if (optopt == 'c')
         fprintf(stderr, "Option -%c requires an argument.\n", optopt);
       else if (isprint(optopt))
         fprintf(stderr, "Unknown option `-%c'.\n", optopt);
@@ -113,4 +497,20 @@ void parseCLI(int argc, char **argv)
   for (int index = optind; index < argc; index++) {
     printf("Non-option argument %s\n", argv[index]);
   }
+
+  if (load_kernel < 0) {
+    load_kernel = registry_find("triad");
+  }
+
+  if (ci_target > 0.0 && !itersGiven) {
+    ITERS = ADAPTIVE_MAXITERS;
+  }
+  // The scaling mode fills the cores of one NUMA node after the other
+  if (type == SCALING && !pinGiven) {
+    affinity_parsePinExpression("no-smt");
+  }
+  // The chasing thread must not migrate during the loaded latency measurement
+  if (type == LOADED && !pinGiven) {
+    affinity_parsePinExpression("compact");
+  }
 }
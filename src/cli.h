@@ -7,16 +7,61 @@
 
 #include <stddef.h>
 
-typedef enum { WS = 0, TP, SQ, NUMTYPES } types;
+typedef enum { WS = 0, TP, SQ, LOADED, SCALING, NUMTYPES } types;
+typedef enum { DT_DOUBLE = 0, DT_FLOAT, DT_INT32, DT_INT64, NUMDATATYPES } datatypes;
+#define INTEGER_TYPE(type) ((type) == DT_INT32 || (type) == DT_INT64)
+typedef enum { STORES_REGULAR = 0, STORES_NT, STORES_AUTO, NUMSTOREMODES } storemodes;
+typedef enum { PREFETCH_T0 = 0, PREFETCH_NTA, NUMPREFETCHHINTS } prefetchhints;
 
 #define HELPTEXT                                                                         \
   "Usage: bwBench [options]\n\n"                                                         \
   "Options:\n"                                                                           \
   "  -h              Show this help text\n"                                              \
-  "  -m <type>       Benchmark type, can be ws (default), tp, or seq.\n"                 \
+  "  -m <type>       Benchmark type, can be ws (default), tp, seq, loaded, or\n"         \
+  "                  scaling\n"                                                          \
+  "  -l <kernel>     Load kernel for loaded mode, can be triad (default), copy, or sum\n" \
+  "  -k <kernels>    Comma separated list of kernels to run, e.g., triad,copy\n"         \
   "  -s <long int>   Size in GB for allocated vectors\n"                                 \
-  "  -n <long int>   Number of iterations\n"                                             \
-  "  -i <type>       Data initialization type, can be constant, or random"               \
+  "  -n <long int>   Number of iterations, the maximum with --ci\n"                      \
+  "  -i <type>       Data initialization type, can be constant, or random\n"             \
+  "  -a <isa>        Kernel variant, can be auto (default), compiler, scalar, sse2,\n"   \
+  "                  avx2, or avx512\n"                                                  \
+  "  -p <expr>       Pin the threads, can be compact, scatter, no-smt,\n"                \
+  "                  numa:<node>[:<count>], or a list like 0-15:2\n"                     \
+  "  -P <policy>     Memory placement, can be firsttouch (default), local,\n"            \
+  "                  interleave, or node:<n>\n"                                          \
+  "  -H <pages>      Page size, can be default, 4k, thp, 2M, or 1G\n"                    \
+  "  --stores=<mode> Store instructions, can be regular (default), nt, or auto\n"        \
+  "  --datatype=<type>\n"                                                                \
+  "                  Element type, can be double (default), float, int32, or int64\n"    \
+  "  --stride=<int>  Stride in elements of the strided kernel, default 8\n"              \
+  "  --index=<type>  Index array of gather and scatter, can be sequential (default),\n"  \
+  "                  blocked[:<n>], or random\n"                                         \
+  "  --ci=<percent>  Repeat until the 95%% confidence interval of the bandwidth is\n"    \
+  "                  within +-percent, default off\n"                                    \
+  "  --budget=<seconds>\n"                                                               \
+  "                  Time budget of the repetitions with --ci, default 60\n"             \
+  "  --sweep-time=<seconds>\n"                                                           \
+  "                  Time per size of the seq and tp sweeps, default 0.5\n"              \
+  "  --private       Thread private input arrays in tp mode\n"                           \
+  "  --output=<format>[:<file>]\n"                                                       \
+  "                  Write the results as json or csv, default file bwbench.<format>\n"  \
+  "  --baseline=<file>\n"                                                                \
+  "                  Compare the ws results to a json or csv file written by --output\n" \
+  "  --tolerance=<percent>\n"                                                            \
+  "                  Slowdown against the baseline that fails the run, default 5\n"      \
+  "  --trace=<file>  Write the per thread timeline of the ws kernels as Chrome trace\n"  \
+  "  --persistent    Run all ws repetitions in a single parallel region\n"               \
+  "  --step <int>    Stepping of the thread counts in scaling mode (default 1)\n"        \
+  "  --counters      Measure hardware counters of the ws kernels with perf_event_open\n" \
+  "  --stencil=<nx>[:<block>]\n"                                                         \
+  "                  Inner dimension and block size of the stencil grids, default\n"     \
+  "                  square or cubic and unblocked\n"                                    \
+  "  --streams=<R>[:<W>]\n"                                                              \
+  "                  Read and write arrays of the N-stream kernel, default 8:1\n"        \
+  "  --prefetch=<bytes>|auto[:<hint>]\n"                                                 \
+  "                  Software prefetch distance of copy, triad and sum, auto sweeps\n"   \
+  "                  the distances, hint can be t0 (default) or nta\n"                   \
   "  -d <int>        (If GPU enabled) GPU ID on which you want your program "            \
   "to run\n"
 
@@ -24,8 +69,38 @@ extern int CUDA_DEVICE;
 extern int type;
 extern int SEQ;
 extern int data_init_type;
+extern int load_kernel;
+extern int kernel_isa;
+extern int placement;
+extern int placement_node;
+extern int page_type;
+extern int store_mode;
+extern int data_type;
+extern size_t STRIDE;
+extern int index_type;
+extern size_t index_block;
+extern const char *dataTypeNames[];
+extern const char *storeModeNames[];
+extern const char *prefetchHintNames[];
+extern const size_t dataTypeSizes[];
 extern size_t N;
 extern size_t ITERS;
+extern double ci_target;
+extern double time_budget;
+extern double sweep_time;
+extern int private_inputs;
+extern int output_format;
+extern double tolerance;
+extern int persistent;
+extern int scaling_step;
+extern int perf_counters;
+extern size_t stencil_inner;
+extern size_t stencil_block;
+extern int stream_reads;
+extern int stream_writes;
+extern size_t prefetch_distance;
+extern int prefetch_hint;
+extern int prefetch_sweep;
 
 extern void parseCLI(int, char **);
 
@@ -0,0 +1,127 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocate.h"
+#include "cli.h"
+#include "indices.h"
+#include "kernels.h"
+
+static const char *indexTypeNames[NUMINDEXTYPES] = {
+  "sequential",
+  "blocked",
+  "random",
+};
+
+static uint32_t *_index = NULL;
+static size_t _length   = 0;
+static size_t _lines    = 0;
+
+int index_parseType(const char *arg)
+{
+  if (strncmp(arg, "blocked:", 8) == 0) {
+    char *end;
+    errno          = 0;
+    const long val = strtol(arg + 8, &end, 10);
+    if (arg[8] == '\0' || *end != '\0' || errno != 0 || val < 1) {
+      return -1;
+    }
+    index_type  = BLOCKED;
+    index_block = (size_t)val;
+    return 0;
+  }
+
+  for (int i = 0; i < NUMINDEXTYPES; i++) {
+    if (strcmp(arg, indexTypeNames[i]) == 0) {
+      index_type = i;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+static size_t randomBelow(unsigned int *seed, const size_t n)
+{
+  const size_t r = ((size_t)rand_r(seed) << 31) | (size_t)rand_r(seed);
+  return r % n;
+}
+
+/* Fisher-Yates shuffle of count blocks with blocksize consecutive indices
+ * each, a remainder at the end stays in place */
+static void shuffleBlocks(uint32_t *index, const size_t N, const size_t blocksize)
+{
+  const size_t count = N / blocksize;
+  unsigned int seed  = 1;
+
+  for (size_t i = count - 1; i > 0; i--) {
+    const size_t j = randomBelow(&seed, i + 1);
+
+    for (size_t k = 0; k < blocksize; k++) {
+      const uint32_t tmp       = index[i * blocksize + k];
+      index[i * blocksize + k] = index[j * blocksize + k];
+      index[j * blocksize + k] = tmp;
+    }
+  }
+}
+
+/* Creates a permutation of 0 to N - 1 for the gather and scatter kernels and
+ * counts the cache lines touched by a pass over it. Consecutive indices in the
+ * same cache line are assumed to reuse the line. */
+void index_setup(const size_t N)
+{
+  const size_t lineElements = CACHELINE_SIZE / dataTypeSizes[data_type];
+
+  if (N > UINT32_MAX) {
+    fprintf(stderr, "Error: Array size too large for 32 bit indices\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (_index != NULL) {
+    deallocate(_index, _length * sizeof(uint32_t));
+  }
+  _length = N;
+  _index  = (uint32_t *)allocate(ARRAY_ALIGNMENT, N * sizeof(uint32_t));
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < N; i++) {
+    _index[i] = (uint32_t)i;
+  }
+
+  if (index_type == BLOCKED && N > index_block) {
+    shuffleBlocks(_index, N, index_block);
+  } else if (index_type == RANDOM) {
+    shuffleBlocks(_index, N, 1);
+  }
+
+  _lines = 0;
+  for (size_t i = 0; i < N; i++) {
+    if (i == 0 || _index[i] / lineElements != _index[i - 1] / lineElements) {
+      _lines++;
+    }
+  }
+}
+
+const uint32_t *index_get(void)
+{
+  return _index;
+}
+
+size_t index_getLines(void)
+{
+  return _lines;
+}
+
+void index_printType(void)
+{
+  if (index_type == BLOCKED) {
+    printf("Index array: blocked, %zu elements per block\n", index_block);
+  } else {
+    printf("Index array: %s\n", indexTypeNames[index_type]);
+  }
+}
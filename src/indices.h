@@ -0,0 +1,20 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef INDICES_H
+#define INDICES_H
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { SEQUENTIAL = 0, BLOCKED, RANDOM, NUMINDEXTYPES } indextypes;
+
+#define INDEX_BLOCKSIZE 64
+
+extern int index_parseType(const char *arg);
+extern void index_setup(size_t N);
+extern const uint32_t *index_get(void);
+extern size_t index_getLines(void);
+extern void index_printType(void);
+
+#endif /*INDICES_H*/
@@ -0,0 +1,67 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <string.h>
+
+#include "isa.h"
+#include "simd.h"
+
+static const char *isaNames[NUMISAS] = {
+  "compiler",
+  "scalar",
+  "sse2",
+  "avx2",
+  "avx512",
+};
+
+int isa_parse(const char *arg)
+{
+  if (strcmp(arg, "auto") == 0) {
+    return ISA_AUTO;
+  }
+
+  for (int i = 0; i < NUMISAS; i++) {
+    if (strcmp(arg, isaNames[i]) == 0) {
+      return i;
+    }
+  }
+
+  return NUMISAS;
+}
+
+int isa_isSupported(const int isa)
+{
+  switch (isa) {
+  case ISA_COMPILER:
+    return 1;
+#ifdef SIMD_X86
+  case ISA_SCALAR:
+  case ISA_SSE2:
+    return 1;
+  case ISA_AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case ISA_AVX512:
+    return __builtin_cpu_supports("avx512f");
+#endif
+  default:
+    return 0;
+  }
+}
+
+/* Widest variant supported by the CPU this process is running on */
+int isa_detect(void)
+{
+  for (int isa = NUMISAS - 1; isa > ISA_COMPILER; isa--) {
+    if (isa_isSupported(isa)) {
+      return isa;
+    }
+  }
+
+  return ISA_COMPILER;
+}
+
+const char *isa_getName(const int isa)
+{
+  return isaNames[isa];
+}
@@ -0,0 +1,24 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef ISA_H
+#define ISA_H
+
+typedef enum {
+  ISA_COMPILER = 0,
+  ISA_SCALAR,
+  ISA_SSE2,
+  ISA_AVX2,
+  ISA_AVX512,
+  NUMISAS
+} isas;
+
+#define ISA_AUTO -1
+
+extern int isa_parse(const char *arg);
+extern int isa_isSupported(int isa);
+extern int isa_detect(void);
+extern const char *isa_getName(int isa);
+
+#endif /*ISA_H*/
@@ -0,0 +1,128 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "kernels.h"
+#include "registry.h"
+#include "timing.h"
+
+typedef enum { LOAD_TRIAD = 0, LOAD_COPY, LOAD_SUM } loadKernels;
+
+static void spin(const size_t delay)
+{
+  volatile size_t count = 0;
+
+  for (size_t k = 0; k < delay; k++) {
+    count++;
+  }
+}
+
+/* Thread 0 performs a number of dependent pointer chasing loads on the chain
+ * set up in d. All other threads run the streaming kernel on a, b and c with a
+ * delay after every block until the chase is finished. Returns the runtime of
+ * the chase, the number of elements streamed meanwhile is stored in elements. */
+double loadedLatency(double *restrict a,
+    const double *restrict b,
+    const double *restrict c,
+    double *restrict d,
+    const size_t N,
+    const int kernel,
+    const size_t delay,
+    const size_t loads,
+    size_t *elements)
+{
+  const double scalar = 0.1;
+  int load            = LOAD_TRIAD;
+  double S            = 0.0;
+  double E            = 0.0;
+  double sink         = 0.0;
+  size_t count        = 0;
+  int stop            = 0;
+
+  if (strcmp(_kernels[kernel].label, "Copy") == 0) {
+    load = LOAD_COPY;
+  } else if (strcmp(_kernels[kernel].label, "Sum") == 0) {
+    load = LOAD_SUM;
+  }
+
+#pragma omp parallel reduction(+ : count, sink)
+  {
+#ifdef _OPENMP
+    const int id      = omp_get_thread_num();
+    const int workers = omp_get_num_threads() - 1;
+#else
+    const int id      = 0;
+    const int workers = 0;
+#endif
+
+    /* Every load thread streams on its own part of the arrays in whole blocks.
+     * The caller guarantees N / workers >= LOADED_BLOCKSIZE, a thread without
+     * a block would stream on the part of another thread. */
+    const size_t chunk = workers ? (N / workers) & ~(size_t)(LOADED_BLOCKSIZE - 1) : 0;
+
+#pragma omp barrier
+    if (id == 0) {
+      node *p = (node *)d;
+
+      S       = getTimeStamp();
+      for (size_t i = 0; i < loads; i++) {
+        p = p->next;
+      }
+      E = getTimeStamp();
+
+#pragma omp atomic write
+      stop = 1;
+
+      /* make the compiler think this makes actually sense */
+      if (p == NULL)
+        printf("Chain broken\n");
+    } else if (delay != LOADED_IDLE && chunk > 0) {
+      const size_t start = (id - 1) * chunk;
+      size_t block       = start;
+      int done           = 0;
+
+      while (!done) {
+        switch (load) {
+        case LOAD_COPY:
+          for (size_t i = block; i < block + LOADED_BLOCKSIZE; i++) {
+            a[i] = b[i];
+          }
+          break;
+        case LOAD_SUM:
+          for (size_t i = block; i < block + LOADED_BLOCKSIZE; i++) {
+            sink += a[i];
+          }
+          break;
+        default:
+          for (size_t i = block; i < block + LOADED_BLOCKSIZE; i++) {
+            a[i] = b[i] + scalar * c[i];
+          }
+        }
+        count += LOADED_BLOCKSIZE;
+
+        block += LOADED_BLOCKSIZE;
+        if (block + LOADED_BLOCKSIZE > start + chunk) {
+          block = start;
+        }
+        spin(delay);
+
+#pragma omp atomic read
+        done = stop;
+      }
+    }
+  }
+
+  /* make the compiler think this makes actually sense */
+  if (sink < 0.0)
+    printf("Sum = %f\n", sink);
+
+  *elements = count;
+  return E - S;
+}
@@ -3,57 +3,299 @@
  * Use of this source code is governed by a MIT style
  * license that can be found in the LICENSE file. */
 #include <stdio.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "allocate.h"
 #include "cli.h"
+#include "isa.h"
 #include "kernels.h"
+#include "numa.h"
+#include "registry.h"
+#include "simd.h"
+#include "stencil.h"
+#include "streams.h"
 #include "timing.h"
 
-#ifdef AVX512_INTRINSICS
-#include <immintrin.h>
-#endif
+static void initConstants(double *, double *, double *, double *, const size_t);
+static void initRandoms(double *, double *, double *, double *, const size_t);
 
-#ifdef AVX512_INTRINSICS
-#define INCREMENT i += 8
+// Per thread time stamps of the worksharing kernels, see profilerRecordThreads
+#ifdef _OPENMP
+#define THREAD_ID omp_get_thread_num()
 #else
-#define INCREMENT i++
+#define THREAD_ID 0
 #endif
+#define THREAD_START() _threadTimes[THREAD_ID].start = getTimeStamp()
+#define THREAD_STOP() _threadTimes[THREAD_ID].end = getTimeStamp()
 
-static void initConstants(double *, double *, double *, double *, const size_t);
-static void initRandoms(double *, double *, double *, double *, const size_t);
+#define DTYPE double
+#define ISA compiler
+#include "kernels-simd.h"
+#undef ISA
 
-// Adding simd clause because ICX compiler does
-// not vectorise the code due to size_t dataype.
-#define HARNESS(kernel)                                                                  \
-  double S, E;                                                                           \
-  S = getTimeStamp();                                                                    \
-  _Pragma("omp parallel for simd schedule(static)") for (size_t i = 0; i < N; INCREMENT) \
-  {                                                                                      \
-    kernel;                                                                              \
-  }                                                                                      \
-  E = getTimeStamp();                                                                    \
-  return E - S;
+#ifdef SIMD_X86
+#define ISA scalar
+#include "kernels-simd.h"
+#undef ISA
+
+#define ISA sse2
+#include "kernels-simd.h"
+#undef ISA
+
+#define ISA avx2
+#include "kernels-simd.h"
+#undef ISA
+
+#define ISA avx512
+#include "kernels-simd.h"
+#undef ISA
+#endif
+#undef DTYPE
+
+// Other element types are only available in the compiler variant
+#define ISA compiler
+#define DTYPE float
+#include "kernels-simd.h"
+#undef DTYPE
+
+#define DTYPE int32
+#include "kernels-simd.h"
+#undef DTYPE
+
+#define DTYPE int64
+#include "kernels-simd.h"
+#undef DTYPE
+#undef ISA
+
+// Variants without parallel region for the persistent mode
+#define PERSISTENT
+#define DTYPE double
+#define ISA compiler
+#include "kernels-simd.h"
+#undef ISA
+
+#ifdef SIMD_X86
+#define ISA scalar
+#include "kernels-simd.h"
+#undef ISA
+
+#define ISA sse2
+#include "kernels-simd.h"
+#undef ISA
+
+#define ISA avx2
+#include "kernels-simd.h"
+#undef ISA
+
+#define ISA avx512
+#include "kernels-simd.h"
+#undef ISA
+#endif
+#undef DTYPE
+
+// Other element types are only available in the compiler variant
+#define ISA compiler
+#define DTYPE float
+#include "kernels-simd.h"
+#undef DTYPE
+
+#define DTYPE int32
+#include "kernels-simd.h"
+#undef DTYPE
+
+#define DTYPE int64
+#include "kernels-simd.h"
+#undef DTYPE
+#undef ISA
+#undef PERSISTENT
+
+typedef struct {
+  double (*init)(double *, double, size_t);
+  double (*sum)(double *, size_t);
+  double (*update)(double *, double, size_t);
+  double (*copy)(double *, const double *, size_t);
+  double (*triad)(double *, const double *, const double *, double, size_t);
+  double (*striad)(double *, const double *, const double *, const double *, size_t);
+  double (*daxpy)(double *, const double *, double, size_t);
+  double (*sdaxpy)(double *, const double *, const double *, size_t);
+  double (*strided)(double *, const double *, size_t, size_t);
+  double (*gather)(double *, const double *, const uint32_t *, size_t);
+  double (*scatter)(double *, const double *, const uint32_t *, size_t);
+  double (*stencil2d)(double *, const double *, double, size_t);
+  double (*stencil3d)(double *, const double *, double, size_t);
+  double (*streams)(double *const *, double *const *, int, int, double, size_t);
+  double (*copyPrefetch)(double *, const double *, size_t, int, size_t);
+  double (*triadPrefetch)(
+      double *, const double *, const double *, double, size_t, int, size_t);
+  double (*sumPrefetch)(double *, size_t, int, size_t);
+} kernelVariant;
+
+// suffix is empty for the regular and _persistent for the persistent variants
+#define VARIANT(isa, dtype, suffix)                                                      \
+  { init_##isa##_##dtype##suffix,                                                        \
+    sum_##isa##_##dtype##suffix,                                                         \
+    update_##isa##_##dtype##suffix,                                                      \
+    copy_##isa##_##dtype##suffix,                                                        \
+    triad_##isa##_##dtype##suffix,                                                       \
+    striad_##isa##_##dtype##suffix,                                                      \
+    daxpy_##isa##_##dtype##suffix,                                                       \
+    sdaxpy_##isa##_##dtype##suffix,                                                      \
+    strided_##isa##_##dtype##suffix,                                                     \
+    gather_##isa##_##dtype##suffix,                                                      \
+    scatter_##isa##_##dtype##suffix,                                                     \
+    stencil2d_##isa##_##dtype##suffix,                                                   \
+    stencil3d_##isa##_##dtype##suffix,                                                   \
+    streams_##isa##_##dtype##suffix,                                                     \
+    copyPrefetch_##isa##_##dtype##suffix,                                                \
+    triadPrefetch_##isa##_##dtype##suffix,                                               \
+    sumPrefetch_##isa##_##dtype##suffix }
+
+// Variants not available on this architecture are left empty
+static const kernelVariant _variants[NUMISAS] = {
+  VARIANT(compiler, double, ),
+#ifdef SIMD_X86
+  VARIANT(scalar, double, ),
+  VARIANT(sse2, double, ),
+  VARIANT(avx2, double, ),
+  VARIANT(avx512, double, ),
+#endif
+};
+
+// Compiler variants of the other element types, indexed by data_type
+static const kernelVariant _typeVariants[NUMDATATYPES] = {
+  VARIANT(compiler, double, ),
+  VARIANT(compiler, float, ),
+  VARIANT(compiler, int32, ),
+  VARIANT(compiler, int64, ),
+};
+
+static const kernelVariant _persistentVariants[NUMISAS] = {
+  VARIANT(compiler, double, _persistent),
+#ifdef SIMD_X86
+  VARIANT(scalar, double, _persistent),
+  VARIANT(sse2, double, _persistent),
+  VARIANT(avx2, double, _persistent),
+  VARIANT(avx512, double, _persistent),
+#endif
+};
+
+static const kernelVariant _persistentTypeVariants[NUMDATATYPES] = {
+  VARIANT(compiler, double, _persistent),
+  VARIANT(compiler, float, _persistent),
+  VARIANT(compiler, int32, _persistent),
+  VARIANT(compiler, int64, _persistent),
+};
+
+static const kernelVariant *getVariant(void)
+{
+  if (persistent) {
+    return data_type == DT_DOUBLE ? &_persistentVariants[kernel_isa]
+                                  : &_persistentTypeVariants[data_type];
+  }
+
+  return data_type == DT_DOUBLE ? &_variants[kernel_isa] : &_typeVariants[data_type];
+}
+
+// The copy, triad and sum wrappers use the prefetch variants if --prefetch is given
+#define PREFETCH_NTA_HINT (prefetch_hint == PREFETCH_NTA)
+
+static size_t getLastLevelCacheSize(void)
+{
+  long size = 0;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+  size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (size <= 0) {
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  }
+#endif
+
+  return size > 0 ? (size_t)size : 32ull << 20;
+}
+
+/* Non-temporal stores are used if requested, or in auto mode if an array does
+ * not fit into the last level cache */
+int useStreamingStores(const size_t bytes)
+{
+#ifdef SIMD_X86
+  static size_t llcSize = 0;
+
+  switch (store_mode) {
+  case STORES_NT:
+    return 1;
+  case STORES_AUTO:
+    if (llcSize == 0) {
+      llcSize = getLastLevelCacheSize();
+    }
+    return bytes > llcSize;
+  default:
+    return 0;
+  }
+#else
+  return 0;
+#endif
+}
 
 void allocateArrays(double **a, double **b, double **c, double **d, const size_t N)
 {
-  *a = (double *)allocate(ARRAY_ALIGNMENT, N * sizeof(double));
-  *b = (double *)allocate(ARRAY_ALIGNMENT, N * sizeof(double));
-  *c = (double *)allocate(ARRAY_ALIGNMENT, N * sizeof(double));
-  *d = (double *)allocate(ARRAY_ALIGNMENT, N * sizeof(double));
+  const size_t alignment = numa_getAlignment(ARRAY_ALIGNMENT);
+  const size_t bytes     = N * registry_getArrayWordSize();
+
+  *a = (double *)allocate(alignment, bytes);
+  *b = (double *)allocate(alignment, bytes);
+  *c = (double *)allocate(alignment, bytes);
+  *d = (double *)allocate(alignment, bytes);
+
+  // Placement policy has to be set before the first touch in initArrays
+  numa_setPlacement(*a, allocatedSize(bytes));
+  numa_setPlacement(*b, allocatedSize(bytes));
+  numa_setPlacement(*c, allocatedSize(bytes));
+  numa_setPlacement(*d, allocatedSize(bytes));
 }
 
+// Sets the first N elements of the arrays, which are accessed as type T
+#define FILL(T, va, vb, vc, vd)                                                          \
+  _Pragma("omp for schedule(static)") for (size_t i = 0; i < N; i++)                     \
+  {                                                                                      \
+    ((T *)a)[i] = (T)(va);                                                               \
+    ((T *)b)[i] = (T)(vb);                                                               \
+    ((T *)c)[i] = (T)(vc);                                                               \
+    ((T *)d)[i] = (T)(vd);                                                               \
+  }
+
+#define FILL_DATATYPE(va, vb, vc, vd)                                                    \
+  switch (data_type) {                                                                   \
+  case DT_FLOAT:                                                                         \
+    FILL(ELEMENT_float, va, vb, vc, vd);                                                 \
+    break;                                                                               \
+  case DT_INT32:                                                                         \
+    FILL(ELEMENT_int32, va, vb, vc, vd);                                                 \
+    break;                                                                               \
+  case DT_INT64:                                                                         \
+    FILL(ELEMENT_int64, va, vb, vc, vd);                                                 \
+    break;                                                                               \
+  default:                                                                               \
+    FILL(ELEMENT_double, va, vb, vc, vd);                                                \
+  }
+
 void initConstants(double *a, double *b, double *c, double *d, const size_t N)
 {
 
-#pragma omp parallel for schedule(static)
-  for (size_t i = 0; i < N; i++) {
-    a[i] = 2.0;
-    b[i] = 2.0;
-    c[i] = 0.5;
-    d[i] = 1.0;
+#pragma omp parallel
+  {
+    // 0.5 would truncate to 0 in the integer types
+    FILL_DATATYPE(2.0, 2.0, INTEGER_TYPE(data_type) ? 1.0 : 0.5, 1.0)
   }
 }
 
+// Random integers for the integer types, values below one would truncate to 0
+#define RANDOM                                                                           \
+  (INTEGER_TYPE(data_type) ? (double)(rand_r(&seed) % 256)                               \
+                           : (double)rand_r(&seed) / RAND_MAX)
+
 void initRandoms(double *a, double *b, double *c, double *d, const size_t N)
 {
 
@@ -61,13 +303,7 @@ void initRandoms(double *a, double *b, double *c, double *d, const size_t N)
   {
     unsigned int seed = time(NULL); // unique seed per thread
 
-#pragma omp for schedule(static)
-    for (size_t i = 0; i < N; i++) {
-      a[i] = (double)rand_r(&seed) / RAND_MAX;
-      b[i] = (double)rand_r(&seed) / RAND_MAX;
-      c[i] = (double)rand_r(&seed) / RAND_MAX;
-      d[i] = (double)rand_r(&seed) / RAND_MAX;
-    }
+    FILL_DATATYPE(RANDOM, RANDOM, RANDOM, RANDOM)
   }
 }
 
@@ -83,53 +319,30 @@ void initArrays(double *a, double *b, double *c, double *d, const size_t N)
 
 double init(double *restrict a, const double scalar, const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  __m512d vs =
-      _mm512_set_pd(scalar, scalar, scalar, scalar, scalar, scalar, scalar, scalar);
-
-  HARNESS(_mm512_stream_pd(&a[i], vs))
-#else
-  HARNESS(a[i] = scalar)
-#endif
+  return getVariant()->init(a, scalar, N);
 }
 
 double sum(double *restrict a, const size_t N)
 {
-  double sum     = 0.0;
-
-  const double S = getTimeStamp();
-#pragma omp parallel for reduction(+ : sum) schedule(static)
-  for (size_t i = 0; i < N; i++) {
-    sum += a[i];
+  if (prefetch_distance > 0) {
+    return getVariant()->sumPrefetch(a, prefetch_distance, PREFETCH_NTA_HINT, N);
   }
-  const double E = getTimeStamp();
-
-  /* make the compiler think this makes actually sense */
-  a[10] = sum;
 
-  return E - S;
+  return getVariant()->sum(a, N);
 }
 
 double update(double *restrict a, const double scalar, const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  __m512d vs =
-      _mm512_set_pd(scalar, scalar, scalar, scalar, scalar, scalar, scalar, scalar);
-
-  HARNESS(__m512d prod = _mm512_mul_pd(_mm512_load_pd(&a[i]), vs);
-      _mm512_stream_pd(&a[i], prod);)
-#else
-  HARNESS(a[i] = a[i] * scalar)
-#endif
+  return getVariant()->update(a, scalar, N);
 }
 
 double copy(double *restrict a, const double *restrict b, const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  HARNESS(__m512d load = _mm512_load_pd(&b[i]); _mm512_stream_pd(&a[i], load);)
-#else
-  HARNESS(a[i] = b[i])
-#endif
+  if (prefetch_distance > 0) {
+    return getVariant()->copyPrefetch(a, b, prefetch_distance, PREFETCH_NTA_HINT, N);
+  }
+
+  return getVariant()->copy(a, b, N);
 }
 
 double triad(double *restrict a,
@@ -138,16 +351,12 @@ double triad(double *restrict a,
     const double scalar,
     const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  __m512d vs =
-      _mm512_set_pd(scalar, scalar, scalar, scalar, scalar, scalar, scalar, scalar);
+  if (prefetch_distance > 0) {
+    return getVariant()->triadPrefetch(
+        a, b, c, scalar, prefetch_distance, PREFETCH_NTA_HINT, N);
+  }
 
-  HARNESS(__m512d bvec = _mm512_load_pd(&b[i]);
-      __m512d avec     = _mm512_fmadd_pd(_mm512_load_pd(&c[i]), vs, bvec);
-      _mm512_stream_pd(&a[i], avec);)
-#else
-  HARNESS(a[i] = b[i] + scalar * c[i])
-#endif
+  return getVariant()->triad(a, b, c, scalar, N);
 }
 
 double striad(double *restrict a,
@@ -156,28 +365,13 @@ double striad(double *restrict a,
     const double *restrict d,
     const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  HARNESS(__m512d bvec = _mm512_load_pd(&b[i]); __m512d dvec = _mm512_load_pd(&d[i]);
-      __m512d avec = _mm512_fmadd_pd(_mm512_load_pd(&c[i]), dvec, bvec);
-      _mm512_stream_pd(&a[i], avec);)
-#else
-  HARNESS(a[i] = b[i] + d[i] * c[i])
-#endif
+  return getVariant()->striad(a, b, c, d, N);
 }
 
 double daxpy(
     double *restrict a, const double *restrict b, const double scalar, const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  __m512d vs =
-      _mm512_set_pd(scalar, scalar, scalar, scalar, scalar, scalar, scalar, scalar);
-
-  HARNESS(__m512d bvec = _mm512_load_pd(&b[i]);
-      __m512d avec     = _mm512_fmadd_pd(bvec, vs, _mm512_load_pd(&a[i]));
-      _mm512_stream_pd(&a[i], avec);)
-#else
-  HARNESS(a[i] = a[i] + scalar * b[i])
-#endif
+  return getVariant()->daxpy(a, b, scalar, N);
 }
 
 double sdaxpy(double *restrict a,
@@ -185,11 +379,45 @@ double sdaxpy(double *restrict a,
     const double *restrict c,
     const size_t N)
 {
-#ifdef AVX512_INTRINSICS
-  HARNESS(__m512d bvec = _mm512_load_pd(&b[i]); __m512d cvec = _mm512_load_pd(&c[i]);
-      __m512d avec = _mm512_fmadd_pd(bvec, cvec, _mm512_load_pd(&a[i]));
-      _mm512_stream_pd(&a[i], avec);)
-#else
-  HARNESS(a[i] = a[i] + b[i] * c[i])
-#endif
+  return getVariant()->sdaxpy(a, b, c, N);
+}
+
+double strided(
+    double *restrict a, const double *restrict b, const size_t N, const size_t stride)
+{
+  return getVariant()->strided(a, b, N, stride);
+}
+
+double gather(double *restrict a,
+    const double *restrict b,
+    const uint32_t *restrict index,
+    const size_t N)
+{
+  return getVariant()->gather(a, b, index, N);
+}
+
+double scatter(double *restrict a,
+    const double *restrict b,
+    const uint32_t *restrict index,
+    const size_t N)
+{
+  return getVariant()->scatter(a, b, index, N);
+}
+
+double stencil2d(
+    double *restrict a, const double *restrict b, const double weight, const size_t N)
+{
+  return getVariant()->stencil2d(a, b, weight, N);
+}
+
+double stencil3d(
+    double *restrict a, const double *restrict b, const double weight, const size_t N)
+{
+  return getVariant()->stencil3d(a, b, weight, N);
+}
+
+double streams(const int reads, const int writes, const double scalar, const size_t N)
+{
+  return getVariant()->streams(
+      streams_getInputs(), streams_getOutputs(), reads, writes, scalar, N);
 }
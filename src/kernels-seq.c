@@ -5,39 +5,102 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "cli.h"
 #include "kernels.h"
+#include "simd.h"
+#include "stencil.h"
+#include "streams.h"
 #include "timing.h"
 
-#define HARNESS(kernel)                                                                  \
-  const double S = getTimeStamp();                                                       \
-  for (size_t j = 0; j < iter; j++) {                                                    \
-    for (size_t i = 0; i < N; i++) {                                                     \
-      kernel;                                                                            \
-    }                                                                                    \
-    if (a[N - 1] < 0.0) {                                                                \
-      printf("Ai = %f\n", a[N - 1]);                                                     \
-      exit(1);                                                                           \
-    }                                                                                    \
-  }                                                                                      \
-  const double E = getTimeStamp();                                                       \
-  return E - S;
+#define DTYPE double
+#include "kernels-seq.h"
+#undef DTYPE
+
+#define DTYPE float
+#include "kernels-seq.h"
+#undef DTYPE
+
+#define DTYPE int32
+#include "kernels-seq.h"
+#undef DTYPE
+
+#define DTYPE int64
+#include "kernels-seq.h"
+#undef DTYPE
+
+typedef struct {
+  double (*init)(double *, double, size_t, size_t);
+  double (*sum)(double *, size_t, size_t);
+  double (*update)(double *, double, size_t, size_t);
+  double (*copy)(double *, const double *, size_t, size_t);
+  double (*triad)(double *, const double *, const double *, double, size_t, size_t);
+  double (*striad)(
+      double *, const double *, const double *, const double *, size_t, size_t);
+  double (*daxpy)(double *, const double *, double, size_t, size_t);
+  double (*sdaxpy)(double *, const double *, const double *, size_t, size_t);
+  double (*strided)(double *, const double *, size_t, size_t, size_t);
+  double (*gather)(double *, const double *, const uint32_t *, size_t, size_t);
+  double (*scatter)(double *, const double *, const uint32_t *, size_t, size_t);
+  double (*stencil2d)(double *, const double *, double, size_t, size_t);
+  double (*stencil3d)(double *, const double *, double, size_t, size_t);
+  double (*streams)(double *const *, double *const *, int, int, double, size_t, size_t);
+  double (*copyPrefetch)(double *, const double *, size_t, int, size_t, size_t);
+  double (*triadPrefetch)(
+      double *, const double *, const double *, double, size_t, int, size_t, size_t);
+  double (*sumPrefetch)(double *, size_t, int, size_t, size_t);
+} kernelVariant;
+
+#define VARIANT(dtype)                                                                   \
+  { init_seq_##dtype,                                                                    \
+    sum_seq_##dtype,                                                                     \
+    update_seq_##dtype,                                                                  \
+    copy_seq_##dtype,                                                                    \
+    triad_seq_##dtype,                                                                   \
+    striad_seq_##dtype,                                                                  \
+    daxpy_seq_##dtype,                                                                   \
+    sdaxpy_seq_##dtype,                                                                  \
+    strided_seq_##dtype,                                                                 \
+    gather_seq_##dtype,                                                                  \
+    scatter_seq_##dtype,                                                                 \
+    stencil2d_seq_##dtype,                                                               \
+    stencil3d_seq_##dtype,                                                               \
+    streams_seq_##dtype,                                                                 \
+    copyPrefetch_seq_##dtype,                                                            \
+    triadPrefetch_seq_##dtype,                                                           \
+    sumPrefetch_seq_##dtype }
+
+// Indexed by data_type
+static const kernelVariant _variants[NUMDATATYPES] = {
+  VARIANT(double),
+  VARIANT(float),
+  VARIANT(int32),
+  VARIANT(int64),
+};
+
+// The copy, triad and sum wrappers use the prefetch variants if --prefetch is given
+#define PREFETCH_NTA_HINT (prefetch_hint == PREFETCH_NTA)
 
 double init_seq(
     double *restrict a, const double scalar, const size_t N, const size_t iter)
 {
-  HARNESS(a[i] = scalar)
+  return _variants[data_type].init(a, scalar, N, iter);
 }
 
 double update_seq(
     double *restrict a, const double scalar, const size_t N, const size_t iter)
 {
-  HARNESS(a[i] = a[i] * scalar)
+  return _variants[data_type].update(a, scalar, N, iter);
 }
 
 double copy_seq(
     double *restrict a, const double *restrict b, const size_t N, const size_t iter)
 {
-  HARNESS(a[i] = b[i])
+  if (prefetch_distance > 0) {
+    return _variants[data_type].copyPrefetch(
+        a, b, prefetch_distance, PREFETCH_NTA_HINT, N, iter);
+  }
+
+  return _variants[data_type].copy(a, b, N, iter);
 }
 
 double triad_seq(double *restrict a,
@@ -47,7 +110,12 @@ double triad_seq(double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(a[i] = b[i] + scalar * c[i])
+  if (prefetch_distance > 0) {
+    return _variants[data_type].triadPrefetch(
+        a, b, c, scalar, prefetch_distance, PREFETCH_NTA_HINT, N, iter);
+  }
+
+  return _variants[data_type].triad(a, b, c, scalar, N, iter);
 }
 
 double striad_seq(double *restrict a,
@@ -57,7 +125,7 @@ double striad_seq(double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(a[i] = b[i] + d[i] * c[i])
+  return _variants[data_type].striad(a, b, c, d, N, iter);
 }
 
 double daxpy_seq(double *restrict a,
@@ -66,7 +134,7 @@ double daxpy_seq(double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(a[i] = a[i] + scalar * b[i])
+  return _variants[data_type].daxpy(a, b, scalar, N, iter);
 }
 
 double sdaxpy_seq(double *restrict a,
@@ -75,25 +143,114 @@ double sdaxpy_seq(double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(a[i] = a[i] + b[i] * c[i])
+  return _variants[data_type].sdaxpy(a, b, c, N, iter);
 }
 
 double sum_seq(double *restrict a, const size_t N, const size_t iter)
 {
-  double sum     = 0.0;
+  if (prefetch_distance > 0) {
+    return _variants[data_type].sumPrefetch(
+        a, prefetch_distance, PREFETCH_NTA_HINT, N, iter);
+  }
+
+  return _variants[data_type].sum(a, N, iter);
+}
+
+double strided_seq(double *restrict a,
+    const double *restrict b,
+    const size_t N,
+    const size_t stride,
+    const size_t iter)
+{
+  return _variants[data_type].strided(a, b, N, stride, iter);
+}
+
+double gather_seq(double *restrict a,
+    const double *restrict b,
+    const uint32_t *restrict index,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].gather(a, b, index, N, iter);
+}
 
-  const double S = getTimeStamp();
+double scatter_seq(double *restrict a,
+    const double *restrict b,
+    const uint32_t *restrict index,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].scatter(a, b, index, N, iter);
+}
+
+double stencil2d_seq(double *restrict a,
+    const double *restrict b,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].stencil2d(a, b, weight, N, iter);
+}
+
+double stencil3d_seq(double *restrict a,
+    const double *restrict b,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].stencil3d(a, b, weight, N, iter);
+}
+
+double streams_seq(const int reads,
+    const int writes,
+    const double scalar,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].streams(
+      streams_getInputs(), streams_getOutputs(), reads, writes, scalar, N, iter);
+}
+
+/* Sattolo's algorithm, the resulting permutation is a single cycle over all
+ * nodes. Successor indices are stored in place and converted to pointers. */
+void initChain(node *chain, const size_t numNodes, unsigned int seed)
+{
+  for (size_t i = 0; i < numNodes; i++) {
+    chain[i].next = (node *)i;
+  }
+
+  for (size_t i = numNodes - 1; i > 0; i--) {
+    const size_t r = ((size_t)rand_r(&seed) << 31) | (size_t)rand_r(&seed);
+    const size_t j = r % i;
+    node *tmp      = chain[i].next;
+    chain[i].next  = chain[j].next;
+    chain[j].next  = tmp;
+  }
+
+  for (size_t i = 0; i < numNodes; i++) {
+    chain[i].next = &chain[(size_t)chain[i].next];
+  }
+}
+
+/* The chain has to be set up with initChain using chainLength(N) nodes */
+double latency_seq(double *restrict a, const size_t N, const size_t iter)
+{
+  const size_t numNodes = chainLength(N);
+  node *p               = (node *)a;
+
+  const double S        = getTimeStamp();
   for (size_t j = 0; j < iter; j++) {
-    for (size_t i = 0; i < N; i++) {
-      sum += a[i];
+    for (size_t i = 0; i < numNodes; i++) {
+      p = p->next;
     }
-
-    a[10] = sum;
   }
   const double E = getTimeStamp();
 
   /* make the compiler think this makes actually sense */
-  a[10] = sum;
+  if (p == NULL) {
+    printf("Chain broken\n");
+    exit(1);
+  }
 
   return E - S;
 }
@@ -0,0 +1,415 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+
+/* Sequential kernels, instantiated once per element type in kernels-seq.c with
+ * DTYPE set to the type name from simd.h. */
+#ifndef DTYPE
+#error "DTYPE has to be defined before including kernels-seq.h"
+#endif
+
+#define FN(name) SIMD_CAT(SIMD_CAT(name, _seq_), DTYPE)
+#define ELEMENT SIMD_CAT(ELEMENT_, DTYPE)
+
+// The arrays are allocated as double and accessed as ELEMENT
+#define ARRAY(x) ELEMENT *restrict x = (ELEMENT *)x##_
+#define CONST_ARRAY(x) const ELEMENT *restrict x = (const ELEMENT *)x##_
+#define SCALAR const ELEMENT scalar = (ELEMENT)scalar_
+
+#define HARNESS(value)                                                                   \
+  const int nt   = useStreamingStores(N * sizeof(ELEMENT));                              \
+  const double S = getTimeStamp();                                                       \
+  for (size_t j = 0; j < iter; j++) {                                                    \
+    if (nt) {                                                                            \
+      NTVEC_LOOP(ELEMENT, a, 0, N, value)                                                \
+      SIMD_SFENCE();                                                                     \
+    } else {                                                                             \
+      for (size_t i = 0; i < N; i++) {                                                   \
+        a[i] = value;                                                                    \
+      }                                                                                  \
+    }                                                                                    \
+    if (a[N - 1] < 0.0) {                                                                \
+      printf("Ai = %f\n", (double)a[N - 1]);                                             \
+      exit(1);                                                                           \
+    }                                                                                    \
+  }                                                                                      \
+  const double E = getTimeStamp();                                                       \
+  return E - S;
+
+static double FN(init)(
+    double *restrict a_, const double scalar_, const size_t N, const size_t iter)
+{
+  ARRAY(a);
+  SCALAR;
+
+  HARNESS(scalar)
+}
+
+static double FN(update)(
+    double *restrict a_, const double scalar_, const size_t N, const size_t iter)
+{
+  ARRAY(a);
+  SCALAR;
+
+  HARNESS(a[i] * scalar)
+}
+
+static double FN(copy)(
+    double *restrict a_, const double *restrict b_, const size_t N, const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  HARNESS(b[i])
+}
+
+static double FN(triad)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double scalar_,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+  SCALAR;
+
+  HARNESS(b[i] + scalar * c[i])
+}
+
+static double FN(striad)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double *restrict d_,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+  CONST_ARRAY(d);
+
+  HARNESS(b[i] + d[i] * c[i])
+}
+
+static double FN(daxpy)(double *restrict a_,
+    const double *restrict b_,
+    const double scalar_,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  SCALAR;
+
+  HARNESS(a[i] + scalar * b[i])
+}
+
+static double FN(sdaxpy)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+
+  HARNESS(a[i] + b[i] * c[i])
+}
+
+static double FN(sum)(double *restrict a_, const size_t N, const size_t iter)
+{
+  ARRAY(a);
+  ELEMENT sum    = 0;
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t i = 0; i < N; i++) {
+      sum += a[i];
+    }
+
+    a[10] = sum;
+  }
+  const double E = getTimeStamp();
+
+  /* make the compiler think this makes actually sense */
+  a[10] = sum;
+
+  return E - S;
+}
+
+/* Software prefetch variants of copy, triad and sum. The loads are prefetched
+ * distance bytes ahead with the hint given by nta, once per cache line. The
+ * loops run over whole lines, the remainder follows without prefetch. */
+#define LINE (CACHELINE_SIZE / sizeof(ELEMENT))
+#define PREFETCH(x) SIMD_PREFETCH(&x[l + ahead], nta)
+#define PREFETCH_LOOP(prefetch, store)                                                   \
+  for (size_t l = 0; l < lines; l += LINE) {                                             \
+    prefetch;                                                                            \
+    for (size_t k = 0; k < LINE; k++) {                                                  \
+      const size_t i = l + k;                                                            \
+      store;                                                                             \
+    }                                                                                    \
+  }                                                                                      \
+  for (size_t i = lines; i < N; i++) {                                                   \
+    store;                                                                               \
+  }
+// Non-temporal form of PREFETCH_LOOP with the vector stores of NTVEC_LOOP
+#define PREFETCH_LOOP_NT(prefetch, value)                                                \
+  for (size_t l = 0; l < lines; l += LINE) {                                             \
+    prefetch;                                                                            \
+    NTVEC_LOOP(ELEMENT, a, l, l + LINE, value)                                           \
+  }                                                                                      \
+  NTVEC_LOOP(ELEMENT, a, lines, N, value)
+#define PREFETCH_HARNESS(prefetch, value)                                                \
+  const int nt       = useStreamingStores(N * sizeof(ELEMENT));                          \
+  const size_t lines = N - N % LINE;                                                     \
+  const size_t ahead = distance / sizeof(ELEMENT);                                       \
+  const double S     = getTimeStamp();                                                   \
+  for (size_t j = 0; j < iter; j++) {                                                    \
+    if (nt) {                                                                            \
+      PREFETCH_LOOP_NT(prefetch, value)                                                  \
+      SIMD_SFENCE();                                                                     \
+    } else {                                                                             \
+      PREFETCH_LOOP(prefetch, a[i] = value)                                              \
+    }                                                                                    \
+    if (a[N - 1] < 0.0) {                                                                \
+      printf("Ai = %f\n", (double)a[N - 1]);                                             \
+      exit(1);                                                                           \
+    }                                                                                    \
+  }                                                                                      \
+  const double E = getTimeStamp();                                                       \
+  return E - S;
+
+static double FN(copyPrefetch)(double *restrict a_,
+    const double *restrict b_,
+    const size_t distance,
+    const int nta,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  PREFETCH_HARNESS(PREFETCH(b), b[i])
+}
+
+static double FN(triadPrefetch)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double scalar_,
+    const size_t distance,
+    const int nta,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+  SCALAR;
+
+  PREFETCH_HARNESS(PREFETCH(b); PREFETCH(c), b[i] + scalar * c[i])
+}
+
+static double FN(sumPrefetch)(double *restrict a_,
+    const size_t distance,
+    const int nta,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  const size_t lines = N - N % LINE;
+  const size_t ahead = distance / sizeof(ELEMENT);
+  ELEMENT sum        = 0;
+  // One partial sum per element of a line, the compiler vectorizes the adds
+  ELEMENT part[LINE] = { 0 };
+
+  const double S     = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t l = 0; l < lines; l += LINE) {
+      PREFETCH(a);
+#pragma omp simd
+      for (size_t k = 0; k < LINE; k++) {
+        part[k] += a[l + k];
+      }
+    }
+    for (size_t i = lines; i < N; i++) {
+      part[0] += a[i];
+    }
+
+    sum = 0;
+    for (size_t k = 0; k < LINE; k++) {
+      sum += part[k];
+    }
+    a[10] = sum;
+  }
+  const double E = getTimeStamp();
+
+  /* make the compiler think this makes actually sense */
+  a[10] = sum;
+
+  return E - S;
+}
+
+static double FN(strided)(double *restrict a_,
+    const double *restrict b_,
+    const size_t N,
+    const size_t stride,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t i = 0; i < N / stride; i++) {
+      a[i * stride] = b[i * stride];
+    }
+  }
+  const double E = getTimeStamp();
+
+  return E - S;
+}
+
+static double FN(gather)(double *restrict a_,
+    const double *restrict b_,
+    const uint32_t *restrict index,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t i = 0; i < N; i++) {
+      a[i] = b[index[i]];
+    }
+  }
+  const double E = getTimeStamp();
+
+  return E - S;
+}
+
+static double FN(scatter)(double *restrict a_,
+    const double *restrict b_,
+    const uint32_t *restrict index,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t i = 0; i < N; i++) {
+      a[index[i]] = b[i];
+    }
+  }
+  const double E = getTimeStamp();
+
+  return E - S;
+}
+
+// Jacobi stencils on the grid of N elements from stencil.h
+static double FN(stencil2d)(double *restrict a_,
+    const double *restrict b_,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  const ELEMENT w = (ELEMENT)weight;
+  stencilGrid g;
+
+  stencil_getGrid(2, N, &g);
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t xb = 0; xb < g.nx; xb += g.block) {
+      for (size_t y = 0; y < g.ny; y++) {
+        STENCIL2D_ROW(a, b, w, g.nx, g.ny, y, xb, MIN(xb + g.block, g.nx));
+      }
+    }
+    for (size_t i = g.nx * g.ny; i < N; i++) {
+      a[i] = b[i];
+    }
+  }
+  const double E = getTimeStamp();
+
+  return E - S;
+}
+
+static double FN(stencil3d)(double *restrict a_,
+    const double *restrict b_,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  const ELEMENT w = (ELEMENT)weight;
+  stencilGrid g;
+
+  stencil_getGrid(3, N, &g);
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t yb = 0; yb < g.ny; yb += g.block) {
+      for (size_t z = 0; z < g.nz; z++) {
+        for (size_t y = yb; y < MIN(yb + g.block, g.ny); y++) {
+          STENCIL3D_ROW(a, b, w, g.nx, g.ny, g.nz, y, z);
+        }
+      }
+    }
+    for (size_t i = g.nx * g.ny * g.nz; i < N; i++) {
+      a[i] = b[i];
+    }
+  }
+  const double E = getTimeStamp();
+
+  return E - S;
+}
+
+// N-stream kernel on the arrays from streams.h
+static double FN(streams)(double *const *in,
+    double *const *out,
+    const int reads,
+    const int writes,
+    const double scalar_,
+    const size_t N,
+    const size_t iter)
+{
+  SCALAR;
+  const size_t line  = STREAMS_LINE(ELEMENT);
+  const size_t lines = N - N % line;
+
+  const double S = getTimeStamp();
+  for (size_t j = 0; j < iter; j++) {
+    for (size_t i = 0; i < lines; i += line) {
+      STREAMS_BLOCK(ELEMENT, in, out, reads, writes, scalar, i, line);
+    }
+    if (lines < N) {
+      STREAMS_BLOCK(ELEMENT, in, out, reads, writes, scalar, lines, N - lines);
+    }
+  }
+  const double E = getTimeStamp();
+
+  return E - S;
+}
+
+#undef FN
+#undef ELEMENT
+#undef ARRAY
+#undef CONST_ARRAY
+#undef SCALAR
+#undef HARNESS
+#undef LINE
+#undef PREFETCH
+#undef PREFETCH_LOOP
+#undef PREFETCH_HARNESS
+#undef PREFETCH_LOOP_NT
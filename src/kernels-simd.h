@@ -0,0 +1,564 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+
+/* Worksharing kernels, instantiated once per variant in kernels-omp.c with ISA
+ * set to the variant name and DTYPE to the element type. Every variant is
+ * compiled for its own instruction set using the primitives from simd.h, only
+ * the compiler variant supports element types other than double. N has to be
+ * a multiple of 4 * WIDTH per thread. Every thread records the start and end of
+ * its share of the loop with THREAD_START and THREAD_STOP. With PERSISTENT
+ * defined the kernels have no parallel region and no timing of their own, they
+ * are called by all threads of the region the caller keeps open. */
+#ifndef ISA
+#error "ISA has to be defined before including kernels-simd.h"
+#endif
+#ifndef DTYPE
+#error "DTYPE has to be defined before including kernels-simd.h"
+#endif
+
+#define NAME(name) SIMD_CAT(SIMD_CAT(SIMD_CAT(SIMD_CAT(name, _), ISA), _), DTYPE)
+#ifdef PERSISTENT
+#define FN(name) SIMD_CAT(NAME(name), _persistent)
+#define REGION
+#define REGION_SUM
+#define TIMER_START
+#define TIMER_STOP return 0.0;
+#else
+#define FN(name) NAME(name)
+#define REGION _Pragma("omp parallel")
+#define REGION_SUM _Pragma("omp parallel reduction(+ : sum)")
+#define TIMER_START const double S = getTimeStamp();
+#define TIMER_STOP return getTimeStamp() - S;
+#endif
+#define ELEMENT SIMD_CAT(ELEMENT_, DTYPE)
+#define VEC SIMD_CAT(VEC_, ISA)
+#define WIDTH SIMD_CAT(WIDTH_, ISA)
+#define ATTR SIMD_CAT(ATTR_, ISA)
+#define INTRINSICS SIMD_CAT(INTRINSICS_, ISA)
+#define LOOP SIMD_CAT(LOOP_, ISA)
+#define SET1 SIMD_CAT(SET1_, ISA)
+#define LOAD SIMD_CAT(LOAD_, ISA)
+#define STORE SIMD_CAT(STORE_, ISA)
+#define STREAM SIMD_CAT(STREAM_, ISA)
+#define ADD SIMD_CAT(ADD_, ISA)
+#define MUL SIMD_CAT(MUL_, ISA)
+#define FMA SIMD_CAT(FMA_, ISA)
+#define REDUCE SIMD_CAT(REDUCE_, ISA)
+
+// The arrays are allocated as double and accessed as ELEMENT
+#define ARRAY(x) ELEMENT *restrict x = (ELEMENT *)x##_
+#define CONST_ARRAY(x) const ELEMENT *restrict x = (const ELEMENT *)x##_
+
+/* Non-temporal stores of value to x. The compiler variant computes whole
+ * vectors of elements, see NTVEC_FOR. */
+#if INTRINSICS
+#define STREAM_LOOP(x, value)                                                            \
+  LOOP for (size_t i = 0; i < N; i += WIDTH)                                             \
+  {                                                                                      \
+    STREAM(&x[i], value);                                                                \
+  }
+#else
+#define STREAM_LOOP(x, value) NTVEC_FOR(ELEMENT, x, N, value)
+#endif
+
+// The store of value to x[i] is either a regular or a non-temporal store
+#define HARNESS(x, value)                                                                \
+  const int nt = useStreamingStores(N * sizeof(ELEMENT));                                \
+  TIMER_START                                                                            \
+  if (nt) {                                                                              \
+    REGION                                                                               \
+    {                                                                                    \
+      THREAD_START();                                                                    \
+      STREAM_LOOP(x, value)                                                              \
+      SIMD_SFENCE();                                                                     \
+      THREAD_STOP();                                                                     \
+    }                                                                                    \
+  } else {                                                                               \
+    REGION                                                                               \
+    {                                                                                    \
+      THREAD_START();                                                                    \
+      LOOP for (size_t i = 0; i < N; i += WIDTH)                                         \
+      {                                                                                  \
+        STORE(&x[i], value);                                                             \
+      }                                                                                  \
+      THREAD_STOP();                                                                     \
+    }                                                                                    \
+  }                                                                                      \
+  TIMER_STOP
+
+static ATTR double FN(init)(double *restrict a_, const double scalar, const size_t N)
+{
+  ARRAY(a);
+  const VEC vs = SET1(scalar);
+
+  HARNESS(a, vs)
+}
+
+static ATTR double FN(sum)(double *restrict a_, const size_t N)
+{
+  ARRAY(a);
+  ELEMENT sum = 0;
+
+  TIMER_START
+#if INTRINSICS
+  // Four independent accumulators hide the latency of the add
+  REGION_SUM
+  {
+    VEC s0 = SET1(0.0);
+    VEC s1 = SET1(0.0);
+    VEC s2 = SET1(0.0);
+    VEC s3 = SET1(0.0);
+
+    THREAD_START();
+    LOOP for (size_t i = 0; i < N; i += 4 * WIDTH)
+    {
+      s0 = ADD(s0, LOAD(&a[i]));
+      s1 = ADD(s1, LOAD(&a[i + WIDTH]));
+      s2 = ADD(s2, LOAD(&a[i + 2 * WIDTH]));
+      s3 = ADD(s3, LOAD(&a[i + 3 * WIDTH]));
+    }
+
+    sum += REDUCE(ADD(ADD(s0, s1), ADD(s2, s3)));
+    THREAD_STOP();
+  }
+#else
+  REGION_SUM
+  {
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < N; i++) {
+      sum += a[i];
+    }
+    THREAD_STOP();
+  }
+#endif
+#ifdef PERSISTENT
+  // Every thread keeps its partial sum, there is no reduction
+  _threadTimes[THREAD_ID].sum = sum;
+  return 0.0;
+#else
+  const double E = getTimeStamp();
+
+  /* make the compiler think this makes actually sense */
+  a[10] = sum;
+
+  return E - S;
+#endif
+}
+
+static ATTR double FN(update)(double *restrict a_, const double scalar, const size_t N)
+{
+  ARRAY(a);
+  const VEC vs = SET1(scalar);
+
+  HARNESS(a, MUL(LOAD(&a[i]), vs))
+}
+
+static ATTR double FN(copy)(
+    double *restrict a_, const double *restrict b_, const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  HARNESS(a, LOAD(&b[i]))
+}
+
+static ATTR double FN(triad)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double scalar,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+  const VEC vs = SET1(scalar);
+
+  HARNESS(a, FMA(LOAD(&c[i]), vs, LOAD(&b[i])))
+}
+
+static ATTR double FN(striad)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double *restrict d_,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+  CONST_ARRAY(d);
+
+  HARNESS(a, FMA(LOAD(&c[i]), LOAD(&d[i]), LOAD(&b[i])))
+}
+
+static ATTR double FN(daxpy)(
+    double *restrict a_, const double *restrict b_, const double scalar, const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  const VEC vs = SET1(scalar);
+
+  HARNESS(a, FMA(LOAD(&b[i]), vs, LOAD(&a[i])))
+}
+
+static ATTR double FN(sdaxpy)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+
+  HARNESS(a, FMA(LOAD(&b[i]), LOAD(&c[i]), LOAD(&a[i])))
+}
+
+/* Software prefetch variants of copy, triad and sum. The loads are prefetched
+ * distance bytes ahead with the hint given by nta, once per cache line. N is a
+ * multiple of the cache line, the loops run over whole lines. */
+#define LINE (CACHELINE_SIZE / sizeof(ELEMENT))
+#define PREFETCH(x) SIMD_PREFETCH(&x[l + ahead], nta)
+// Like LOOP the compiler variant leaves the vectorization of a line to the compiler
+#if INTRINSICS
+#define LINE_LOOP
+#else
+#define LINE_LOOP _Pragma("omp simd")
+#endif
+#define PREFETCH_LOOP(prefetch, store)                                                   \
+  _Pragma("omp for schedule(static) nowait") for (size_t l = 0; l < N; l += LINE)        \
+  {                                                                                      \
+    prefetch;                                                                            \
+    LINE_LOOP for (size_t k = 0; k < LINE; k += WIDTH)                                   \
+    {                                                                                    \
+      const size_t i = l + k;                                                            \
+      store;                                                                             \
+    }                                                                                    \
+  }
+/* Non-temporal stores of the prefetch loop, the compiler variant stores the
+ * vectors of a line like NTVEC_FOR. The lines are aligned. */
+#if INTRINSICS
+#define PREFETCH_STREAM(prefetch, x, value) PREFETCH_LOOP(prefetch, STREAM(&x[i], value))
+#else
+#define PREFETCH_STREAM(prefetch, x, value)                                              \
+  _Pragma("omp for schedule(static) nowait") for (size_t l = 0; l < N; l += LINE)        \
+  {                                                                                      \
+    prefetch;                                                                            \
+    for (size_t k = 0; k < LINE; k += NTVEC_WIDTH(ELEMENT)) {                            \
+      NTVEC_STORE(ELEMENT, x, l + k, value)                                              \
+    }                                                                                    \
+  }
+#endif
+#define PREFETCH_HARNESS(prefetch, x, value)                                             \
+  const int nt       = useStreamingStores(N * sizeof(ELEMENT));                          \
+  const size_t ahead = distance / sizeof(ELEMENT);                                       \
+  TIMER_START                                                                            \
+  if (nt) {                                                                              \
+    REGION                                                                               \
+    {                                                                                    \
+      THREAD_START();                                                                    \
+      PREFETCH_STREAM(prefetch, x, value)                                                \
+      SIMD_SFENCE();                                                                     \
+      THREAD_STOP();                                                                     \
+    }                                                                                    \
+  } else {                                                                               \
+    REGION                                                                               \
+    {                                                                                    \
+      THREAD_START();                                                                    \
+      PREFETCH_LOOP(prefetch, STORE(&x[i], value))                                       \
+      THREAD_STOP();                                                                     \
+    }                                                                                    \
+  }                                                                                      \
+  TIMER_STOP
+
+static ATTR double FN(copyPrefetch)(double *restrict a_,
+    const double *restrict b_,
+    const size_t distance,
+    const int nta,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  PREFETCH_HARNESS(PREFETCH(b), a, LOAD(&b[i]))
+}
+
+static ATTR double FN(triadPrefetch)(double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double scalar,
+    const size_t distance,
+    const int nta,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  CONST_ARRAY(c);
+  const VEC vs = SET1(scalar);
+
+  PREFETCH_HARNESS(PREFETCH(b); PREFETCH(c), a, FMA(LOAD(&c[i]), vs, LOAD(&b[i])))
+}
+
+// Every cache line is prefetched once, the accumulators are the ones of sum
+static ATTR double FN(sumPrefetch)(
+    double *restrict a_, const size_t distance, const int nta, const size_t N)
+{
+  ARRAY(a);
+  const size_t ahead = distance / sizeof(ELEMENT);
+  ELEMENT sum        = 0;
+
+  TIMER_START
+#if INTRINSICS
+  REGION_SUM
+  {
+    VEC s0 = SET1(0.0);
+    VEC s1 = SET1(0.0);
+    VEC s2 = SET1(0.0);
+    VEC s3 = SET1(0.0);
+
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < N; i += 4 * WIDTH) {
+      // A step spans part of a cache line or several of them
+      for (size_t l = i; l < i + 4 * WIDTH && l % LINE == 0; l += LINE) {
+        PREFETCH(a);
+      }
+      s0 = ADD(s0, LOAD(&a[i]));
+      s1 = ADD(s1, LOAD(&a[i + WIDTH]));
+      s2 = ADD(s2, LOAD(&a[i + 2 * WIDTH]));
+      s3 = ADD(s3, LOAD(&a[i + 3 * WIDTH]));
+    }
+
+    sum += REDUCE(ADD(ADD(s0, s1), ADD(s2, s3)));
+    THREAD_STOP();
+  }
+#else
+  REGION_SUM
+  {
+    // One partial sum per element of a line, the compiler vectorizes the adds
+    ELEMENT part[LINE] = { 0 };
+
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t l = 0; l < N; l += LINE) {
+      PREFETCH(a);
+      LINE_LOOP for (size_t k = 0; k < LINE; k++)
+      {
+        part[k] += a[l + k];
+      }
+    }
+
+    for (size_t k = 0; k < LINE; k++) {
+      sum += part[k];
+    }
+    THREAD_STOP();
+  }
+#endif
+#ifdef PERSISTENT
+  _threadTimes[THREAD_ID].sum = sum;
+  return 0.0;
+#else
+  const double E = getTimeStamp();
+
+  /* make the compiler think this makes actually sense */
+  a[10] = sum;
+
+  return E - S;
+#endif
+}
+
+/* The following kernels are plain C, the compiler may use gather and scatter
+ * instructions of the variant's instruction set. */
+static ATTR double FN(strided)(double *restrict a_,
+    const double *restrict b_,
+    const size_t N,
+    const size_t stride)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  TIMER_START
+  REGION
+  {
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < N / stride; i++) {
+      a[i * stride] = b[i * stride];
+    }
+    THREAD_STOP();
+  }
+  TIMER_STOP
+}
+
+static ATTR double FN(gather)(double *restrict a_,
+    const double *restrict b_,
+    const uint32_t *restrict index,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  TIMER_START
+  REGION
+  {
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < N; i++) {
+      a[i] = b[index[i]];
+    }
+    THREAD_STOP();
+  }
+  TIMER_STOP
+}
+
+static ATTR double FN(scatter)(double *restrict a_,
+    const double *restrict b_,
+    const uint32_t *restrict index,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+
+  TIMER_START
+  REGION
+  {
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < N; i++) {
+      a[index[i]] = b[i];
+    }
+    THREAD_STOP();
+  }
+  TIMER_STOP
+}
+
+/* Jacobi stencils on the grid of N elements from stencil.h, the threads share
+ * the blocks and the rows of every block. Elements beyond the grid are
+ * copied. */
+static ATTR double FN(stencil2d)(double *restrict a_,
+    const double *restrict b_,
+    const double weight,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  const ELEMENT w = (ELEMENT)weight;
+  stencilGrid g;
+
+  stencil_getGrid(2, N, &g);
+  const size_t nx = g.nx, ny = g.ny, block = g.block;
+
+  TIMER_START
+  REGION
+  {
+    THREAD_START();
+#pragma omp for schedule(static) collapse(2) nowait
+    for (size_t xb = 0; xb < nx; xb += block) {
+      for (size_t y = 0; y < ny; y++) {
+        STENCIL2D_ROW(a, b, w, nx, ny, y, xb, MIN(xb + block, nx));
+      }
+    }
+#pragma omp for schedule(static) nowait
+    for (size_t i = nx * ny; i < N; i++) {
+      a[i] = b[i];
+    }
+    THREAD_STOP();
+  }
+  TIMER_STOP
+}
+
+static ATTR double FN(stencil3d)(double *restrict a_,
+    const double *restrict b_,
+    const double weight,
+    const size_t N)
+{
+  ARRAY(a);
+  CONST_ARRAY(b);
+  const ELEMENT w = (ELEMENT)weight;
+  stencilGrid g;
+
+  stencil_getGrid(3, N, &g);
+  const size_t nx = g.nx, ny = g.ny, nz = g.nz, block = g.block;
+
+  TIMER_START
+  REGION
+  {
+    THREAD_START();
+#pragma omp for schedule(static) collapse(2) nowait
+    for (size_t yb = 0; yb < ny; yb += block) {
+      for (size_t z = 0; z < nz; z++) {
+        for (size_t y = yb; y < MIN(yb + block, ny); y++) {
+          STENCIL3D_ROW(a, b, w, nx, ny, nz, y, z);
+        }
+      }
+    }
+#pragma omp for schedule(static) nowait
+    for (size_t i = nx * ny * nz; i < N; i++) {
+      a[i] = b[i];
+    }
+    THREAD_STOP();
+  }
+  TIMER_STOP
+}
+
+/* N-stream kernel on the arrays from streams.h, the threads share the cache
+ * lines of the streams */
+static ATTR double FN(streams)(double *const *in,
+    double *const *out,
+    const int reads,
+    const int writes,
+    const double scalar_,
+    const size_t N)
+{
+  const ELEMENT scalar = (ELEMENT)scalar_;
+  const size_t line    = STREAMS_LINE(ELEMENT);
+  const size_t lines   = N - N % line;
+
+  TIMER_START
+  REGION
+  {
+    THREAD_START();
+#pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < lines; i += line) {
+      STREAMS_BLOCK(ELEMENT, in, out, reads, writes, scalar, i, line);
+    }
+    if (lines < N) {
+#pragma omp single nowait
+      STREAMS_BLOCK(ELEMENT, in, out, reads, writes, scalar, lines, N - lines);
+    }
+    THREAD_STOP();
+  }
+  TIMER_STOP
+}
+
+#undef NAME
+#undef FN
+#undef REGION
+#undef REGION_SUM
+#undef TIMER_START
+#undef TIMER_STOP
+#undef ELEMENT
+#undef VEC
+#undef WIDTH
+#undef ATTR
+#undef INTRINSICS
+#undef LOOP
+#undef SET1
+#undef LOAD
+#undef STORE
+#undef STREAM
+#undef ADD
+#undef MUL
+#undef FMA
+#undef REDUCE
+#undef ARRAY
+#undef CONST_ARRAY
+#undef HARNESS
+#undef STREAM_LOOP
+#undef LINE
+#undef PREFETCH
+#undef LINE_LOOP
+#undef PREFETCH_LOOP
+#undef PREFETCH_HARNESS
+#undef PREFETCH_STREAM
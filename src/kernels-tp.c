@@ -3,45 +3,189 @@
  * Use of this source code is governed by a MIT style
  * license that can be found in the LICENSE file. */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "allocate.h"
+#include "cli.h"
 #include "kernels.h"
+#include "simd.h"
+#include "stencil.h"
+#include "streams.h"
 #include "timing.h"
 
-#define HARNESS(kernel)                                                                  \
-  double S, E;                                                                           \
-  _Pragma("omp parallel")                                                                \
-  {                                                                                      \
-    double *al              = (double *)allocate(ARRAY_ALIGNMENT, N * sizeof(double));   \
-    _Pragma("omp single") S = getTimeStamp();                                            \
-    for (size_t j = 0; j < iter; j++) {                                                  \
-      _Pragma("omp simd") for (size_t i = 0; i < N; i++)                                 \
-      {                                                                                  \
-        kernel;                                                                          \
-      }                                                                                  \
-      if (al[N - 1] < 0.0)                                                               \
-        printf("Ai = %f\n", al[N - 1]);                                                  \
-    }                                                                                    \
-    _Pragma("omp barrier") _Pragma("omp single") E = getTimeStamp();                     \
-    free(al);                                                                            \
-  }                                                                                      \
-  return E - S;
+static int getNumThreads(void)
+{
+  int num_threads = 1;
+
+#ifdef _OPENMP
+#pragma omp parallel
+  {
+#pragma omp single
+    num_threads = omp_get_num_threads();
+  }
+#endif
+
+  return num_threads;
+}
+
+/* Thread private buffers of the tp kernels. They are allocated once for the
+ * largest sweep size and first touched by their owner thread, hence no page
+ * faults or allocations fall into the timed region. The output buffer always
+ * exists, the input buffers only with --private. */
+enum { SLOT_OUT = 0, SLOT_a, SLOT_b, SLOT_c, SLOT_d, SLOT_index, NUMSLOTS };
+
+static double **_arena   = NULL;
+static size_t _arenaSize = 0;
+static int _arenaThreads = 0;
+
+static int getThreadId(void)
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+void allocateArena(const size_t bytes)
+{
+  const int slots = private_inputs ? NUMSLOTS : 1;
+
+  _arenaThreads = getNumThreads();
+  _arenaSize    = bytes;
+  _arena        = (double **)calloc(_arenaThreads * NUMSLOTS, sizeof(double *));
+
+#pragma omp parallel
+  {
+    const int id = getThreadId();
+
+    for (int slot = 0; slot < slots; slot++) {
+      double *buffer               = (double *)allocate(ARRAY_ALIGNMENT, bytes);
+      _arena[id * NUMSLOTS + slot] = buffer;
+      memset(buffer, 0, bytes);
+    }
+  }
+}
+
+void freeArena(void)
+{
+  for (int i = 0; i < _arenaThreads * NUMSLOTS; i++) {
+    if (_arena[i] != NULL) {
+      deallocate(_arena[i], _arenaSize);
+    }
+  }
+  free(_arena);
+  _arena = NULL;
+}
+
+// Buffer slot of the calling thread, which has to hold bytes
+static void *getBuffer(const int slot, const size_t bytes)
+{
+  if (_arena == NULL || bytes > _arenaSize) {
+    fprintf(stderr, "Error: Throughput buffer too small for %zu bytes\n", bytes);
+    exit(EXIT_FAILURE);
+  }
+
+  return _arena[getThreadId() * NUMSLOTS + slot];
+}
+
+static void *getArena(const size_t bytes)
+{
+  return getBuffer(SLOT_OUT, bytes);
+}
+
+/* Input array of the calling thread, with --private the thread's own copy of
+ * the shared array in slot. The copy is made by the owner before the timed
+ * region. */
+static const void *getInput(const void *shared, const int slot, const size_t bytes)
+{
+  if (!private_inputs) {
+    return shared;
+  }
+
+  void *buffer = getBuffer(slot, bytes);
+  memcpy(buffer, shared, bytes);
+  return buffer;
+}
+
+#define DTYPE double
+#include "kernels-tp.h"
+#undef DTYPE
+
+#define DTYPE float
+#include "kernels-tp.h"
+#undef DTYPE
+
+#define DTYPE int32
+#include "kernels-tp.h"
+#undef DTYPE
+
+#define DTYPE int64
+#include "kernels-tp.h"
+#undef DTYPE
+
+typedef struct {
+  double (*init)(double *, double, size_t, size_t);
+  double (*sum)(const double *, size_t, size_t);
+  double (*update)(const double *, double, size_t, size_t);
+  double (*copy)(double *, const double *, size_t, size_t);
+  double (*triad)(double *, const double *, const double *, double, size_t, size_t);
+  double (*striad)(
+      double *, const double *, const double *, const double *, size_t, size_t);
+  double (*daxpy)(const double *, const double *, double, size_t, size_t);
+  double (*sdaxpy)(const double *, const double *, const double *, size_t, size_t);
+  double (*strided)(double *, const double *, size_t, size_t, size_t);
+  double (*gather)(double *, const double *, const uint32_t *, size_t, size_t);
+  double (*scatter)(double *, const double *, const uint32_t *, size_t, size_t);
+  double (*stencil2d)(double *, const double *, double, size_t, size_t);
+  double (*stencil3d)(double *, const double *, double, size_t, size_t);
+  double (*streams)(int, int, double, size_t, size_t);
+} kernelVariant;
+
+#define VARIANT(dtype)                                                                   \
+  { init_tp_##dtype,                                                                     \
+    sum_tp_##dtype,                                                                      \
+    update_tp_##dtype,                                                                   \
+    copy_tp_##dtype,                                                                     \
+    triad_tp_##dtype,                                                                    \
+    striad_tp_##dtype,                                                                   \
+    daxpy_tp_##dtype,                                                                    \
+    sdaxpy_tp_##dtype,                                                                   \
+    strided_tp_##dtype,                                                                  \
+    gather_tp_##dtype,                                                                   \
+    scatter_tp_##dtype,                                                                  \
+    stencil2d_tp_##dtype,                                                                \
+    stencil3d_tp_##dtype,                                                                \
+    streams_tp_##dtype }
+
+// Indexed by data_type
+static const kernelVariant _variants[NUMDATATYPES] = {
+  VARIANT(double),
+  VARIANT(float),
+  VARIANT(int32),
+  VARIANT(int64),
+};
 
 double init_tp(double *restrict a, const double scalar, const size_t N, const size_t iter)
 {
-  HARNESS(al[i] = scalar)
+  return _variants[data_type].init(a, scalar, N, iter);
 }
 
 double update_tp(
     const double *restrict a, const double scalar, const size_t N, const size_t iter)
 {
-  HARNESS(al[i] = a[i] * scalar)
+  return _variants[data_type].update(a, scalar, N, iter);
 }
 
 double copy_tp(
     double *restrict a, const double *restrict b, const size_t N, const size_t iter)
 {
-  HARNESS(al[i] = b[i])
+  return _variants[data_type].copy(a, b, N, iter);
 }
 
 double triad_tp(double *restrict a,
@@ -51,7 +195,7 @@ double triad_tp(double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(al[i] = b[i] + scalar * c[i])
+  return _variants[data_type].triad(a, b, c, scalar, N, iter);
 }
 
 double striad_tp(double *restrict a,
@@ -61,7 +205,7 @@ double striad_tp(double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(al[i] = b[i] + d[i] * c[i])
+  return _variants[data_type].striad(a, b, c, d, N, iter);
 }
 
 double daxpy_tp(const double *restrict a,
@@ -70,7 +214,7 @@ double daxpy_tp(const double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(al[i] = a[i] + scalar * b[i])
+  return _variants[data_type].daxpy(a, b, scalar, N, iter);
 }
 
 double sdaxpy_tp(const double *restrict a,
@@ -79,36 +223,91 @@ double sdaxpy_tp(const double *restrict a,
     const size_t N,
     const size_t iter)
 {
-  HARNESS(al[i] = a[i] + b[i] * c[i])
+  return _variants[data_type].sdaxpy(a, b, c, N, iter);
 }
 
 double sum_tp(const double *restrict a, const size_t N, const size_t iter)
 {
+  return _variants[data_type].sum(a, N, iter);
+}
+
+double strided_tp(double *restrict a,
+    const double *restrict b,
+    const size_t N,
+    const size_t stride,
+    const size_t iter)
+{
+  return _variants[data_type].strided(a, b, N, stride, iter);
+}
+
+double gather_tp(double *restrict a,
+    const double *restrict b,
+    const uint32_t *restrict index,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].gather(a, b, index, N, iter);
+}
+
+double scatter_tp(double *restrict a,
+    const double *restrict b,
+    const uint32_t *restrict index,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].scatter(a, b, index, N, iter);
+}
+
+double stencil2d_tp(double *restrict a,
+    const double *restrict b,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].stencil2d(a, b, weight, N, iter);
+}
+
+double stencil3d_tp(double *restrict a,
+    const double *restrict b,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].stencil3d(a, b, weight, N, iter);
+}
+
+double streams_tp(const int reads,
+    const int writes,
+    const double scalar,
+    const size_t N,
+    const size_t iter)
+{
+  return _variants[data_type].streams(reads, writes, scalar, N, iter);
+}
+
+double latency_tp(const size_t N, const size_t iter)
+{
+  const size_t numNodes = chainLength(N);
   double S, E;
 
   _Pragma("omp parallel")
   {
-    double *al = (double *)allocate(ARRAY_ALIGNMENT, N * sizeof(double));
-    _Pragma("omp simd") for (size_t i = 0; i < N; i++)
-    {
-      al[i] = a[i];
-    }
-    double sum              = 0.0;
+    node *chain = (node *)getArena(numNodes * sizeof(node));
+    initChain(chain, numNodes, (unsigned int)(size_t)chain);
+    node *p                 = chain;
 
     _Pragma("omp single") S = getTimeStamp();
     for (size_t j = 0; j < iter; j++) {
-      _Pragma("omp simd") for (size_t i = 0; i < N; i++)
-      {
-        sum += al[i];
+      for (size_t i = 0; i < numNodes; i++) {
+        p = p->next;
       }
-      al[N / 2] += sum;
     }
-    _Pragma("omp single") E = getTimeStamp();
+    _Pragma("omp barrier") _Pragma("omp single") E = getTimeStamp();
 
-    free(al);
+    /* make the compiler think this makes actually sense */
+    if (p == NULL)
+      printf("Chain broken\n");
   }
 
-  /* make the compiler think this makes actually sense */
-
   return E - S;
 }
@@ -0,0 +1,283 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+
+/* Throughput kernels, instantiated once per element type in kernels-tp.c with
+ * DTYPE set to the type name from simd.h. */
+#ifndef DTYPE
+#error "DTYPE has to be defined before including kernels-tp.h"
+#endif
+
+#define FN(name) SIMD_CAT(SIMD_CAT(name, _tp_), DTYPE)
+#define ELEMENT SIMD_CAT(ELEMENT_, DTYPE)
+
+// The arrays are allocated as double and accessed as ELEMENT, all kernels
+// write to the thread private arena buffer. Inputs are the shared arrays or,
+// with --private, thread private copies.
+#define CONST_ARRAY(x) const ELEMENT *restrict x = (const ELEMENT *)x##_
+#define INPUT(x)                                                                         \
+  const ELEMENT *restrict x = (const ELEMENT *)getInput(                                 \
+      x##_, SLOT_##x, N * sizeof(ELEMENT))
+#define INPUT_INDEX                                                                      \
+  const uint32_t *restrict index = (const uint32_t *)getInput(                           \
+      index_, SLOT_index, N * sizeof(uint32_t))
+#define SCALAR const ELEMENT scalar = (ELEMENT)scalar_
+
+#define HARNESS(inputs, value)                                                           \
+  double S, E;                                                                           \
+  const int nt = useStreamingStores(N * sizeof(ELEMENT) * getNumThreads());              \
+  _Pragma("omp parallel")                                                                \
+  {                                                                                      \
+    ELEMENT *al = (ELEMENT *)getArena(N * sizeof(ELEMENT));                              \
+    inputs;                                                                              \
+    _Pragma("omp single") S = getTimeStamp();                                            \
+    for (size_t j = 0; j < iter; j++) {                                                  \
+      if (nt) {                                                                          \
+        NTVEC_LOOP(ELEMENT, al, 0, N, value)                                             \
+        SIMD_SFENCE();                                                                   \
+      } else {                                                                           \
+        _Pragma("omp simd") for (size_t i = 0; i < N; i++)                               \
+        {                                                                                \
+          al[i] = value;                                                                 \
+        }                                                                                \
+      }                                                                                  \
+      if (al[N - 1] < 0.0)                                                               \
+        printf("Ai = %f\n", (double)al[N - 1]);                                          \
+    }                                                                                    \
+    _Pragma("omp barrier") _Pragma("omp single") E = getTimeStamp();                     \
+  }                                                                                      \
+  return E - S;
+
+static double FN(init)(
+    double *restrict a, const double scalar_, const size_t N, const size_t iter)
+{
+  SCALAR;
+
+  HARNESS(, scalar)
+}
+
+static double FN(update)(
+    const double *restrict a_, const double scalar_, const size_t N, const size_t iter)
+{
+  SCALAR;
+
+  HARNESS(INPUT(a), a[i] * scalar)
+}
+
+static double FN(copy)(
+    double *restrict a, const double *restrict b_, const size_t N, const size_t iter)
+{
+  HARNESS(INPUT(b), b[i])
+}
+
+static double FN(triad)(double *restrict a,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double scalar_,
+    const size_t N,
+    const size_t iter)
+{
+  SCALAR;
+
+  HARNESS(INPUT(b); INPUT(c), b[i] + scalar * c[i])
+}
+
+static double FN(striad)(double *restrict a,
+    const double *restrict b_,
+    const double *restrict c_,
+    const double *restrict d_,
+    const size_t N,
+    const size_t iter)
+{
+  HARNESS(INPUT(b); INPUT(c); INPUT(d), b[i] + d[i] * c[i])
+}
+
+static double FN(daxpy)(const double *restrict a_,
+    const double *restrict b_,
+    const double scalar_,
+    const size_t N,
+    const size_t iter)
+{
+  SCALAR;
+
+  HARNESS(INPUT(a); INPUT(b), a[i] + scalar * b[i])
+}
+
+static double FN(sdaxpy)(const double *restrict a_,
+    const double *restrict b_,
+    const double *restrict c_,
+    const size_t N,
+    const size_t iter)
+{
+  HARNESS(INPUT(a); INPUT(b); INPUT(c), a[i] + b[i] * c[i])
+}
+
+static double FN(sum)(const double *restrict a_, const size_t N, const size_t iter)
+{
+  CONST_ARRAY(a);
+  double S, E;
+
+  _Pragma("omp parallel")
+  {
+    ELEMENT *al = (ELEMENT *)getArena(N * sizeof(ELEMENT));
+    _Pragma("omp simd") for (size_t i = 0; i < N; i++)
+    {
+      al[i] = a[i];
+    }
+    ELEMENT sum             = 0;
+
+    _Pragma("omp single") S = getTimeStamp();
+    for (size_t j = 0; j < iter; j++) {
+      _Pragma("omp simd") for (size_t i = 0; i < N; i++)
+      {
+        sum += al[i];
+      }
+      al[N / 2] += sum;
+    }
+    _Pragma("omp single") E = getTimeStamp();
+  }
+
+  /* make the compiler think this makes actually sense */
+
+  return E - S;
+}
+
+// Runs loop with every thread writing to its private array al
+#define PRIVATE(inputs, loop)                                                            \
+  double S, E;                                                                           \
+  _Pragma("omp parallel")                                                                \
+  {                                                                                      \
+    ELEMENT *al = (ELEMENT *)getArena(N * sizeof(ELEMENT));                              \
+    inputs;                                                                              \
+    _Pragma("omp simd") for (size_t i = 0; i < N; i++)                                   \
+    {                                                                                    \
+      al[i] = 0;                                                                         \
+    }                                                                                    \
+    _Pragma("omp single") S = getTimeStamp();                                            \
+    for (size_t j = 0; j < iter; j++) {                                                  \
+      loop;                                                                              \
+      if (al[N - 1] < 0.0)                                                               \
+        printf("Ai = %f\n", (double)al[N - 1]);                                          \
+    }                                                                                    \
+    _Pragma("omp barrier") _Pragma("omp single") E = getTimeStamp();                     \
+  }                                                                                      \
+  return E - S;
+
+static double FN(strided)(double *restrict a,
+    const double *restrict b_,
+    const size_t N,
+    const size_t stride,
+    const size_t iter)
+{
+  PRIVATE(INPUT(b), for (size_t i = 0; i < N / stride; i++) {
+    al[i * stride] = b[i * stride];
+  })
+}
+
+static double FN(gather)(double *restrict a,
+    const double *restrict b_,
+    const uint32_t *restrict index_,
+    const size_t N,
+    const size_t iter)
+{
+  PRIVATE(INPUT(b); INPUT_INDEX, for (size_t i = 0; i < N; i++) { al[i] = b[index[i]]; })
+}
+
+static double FN(scatter)(double *restrict a,
+    const double *restrict b_,
+    const uint32_t *restrict index_,
+    const size_t N,
+    const size_t iter)
+{
+  PRIVATE(INPUT(b); INPUT_INDEX, for (size_t i = 0; i < N; i++) { al[index[i]] = b[i]; })
+}
+
+// Jacobi stencils on the grid of N elements from stencil.h
+static double FN(stencil2d)(double *restrict a,
+    const double *restrict b_,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  const ELEMENT w = (ELEMENT)weight;
+  stencilGrid g;
+
+  stencil_getGrid(2, N, &g);
+  PRIVATE(INPUT(b), {
+    for (size_t xb = 0; xb < g.nx; xb += g.block) {
+      for (size_t y = 0; y < g.ny; y++) {
+        STENCIL2D_ROW(al, b, w, g.nx, g.ny, y, xb, MIN(xb + g.block, g.nx));
+      }
+    }
+    for (size_t i = g.nx * g.ny; i < N; i++) {
+      al[i] = b[i];
+    }
+  })
+}
+
+static double FN(stencil3d)(double *restrict a,
+    const double *restrict b_,
+    const double weight,
+    const size_t N,
+    const size_t iter)
+{
+  const ELEMENT w = (ELEMENT)weight;
+  stencilGrid g;
+
+  stencil_getGrid(3, N, &g);
+  PRIVATE(INPUT(b), {
+    for (size_t yb = 0; yb < g.ny; yb += g.block) {
+      for (size_t z = 0; z < g.nz; z++) {
+        for (size_t y = yb; y < MIN(yb + g.block, g.ny); y++) {
+          STENCIL3D_ROW(al, b, w, g.nx, g.ny, g.nz, y, z);
+        }
+      }
+    }
+    for (size_t i = g.nx * g.ny * g.nz; i < N; i++) {
+      al[i] = b[i];
+    }
+  })
+}
+
+/* N-stream kernel on the arrays from streams.h, every thread writes to its
+ * own output arrays */
+static double FN(streams)(const int reads,
+    const int writes,
+    const double scalar_,
+    const size_t N,
+    const size_t iter)
+{
+  SCALAR;
+  const size_t line  = STREAMS_LINE(ELEMENT);
+  const size_t lines = N - N % line;
+  double S, E;
+
+  _Pragma("omp parallel")
+  {
+    double *const *in  = streams_getInputs();
+    double *const *out = streams_getOutputs();
+
+    _Pragma("omp single") S = getTimeStamp();
+    for (size_t j = 0; j < iter; j++) {
+      for (size_t i = 0; i < lines; i += line) {
+        STREAMS_BLOCK(ELEMENT, in, out, reads, writes, scalar, i, line);
+      }
+      if (lines < N) {
+        STREAMS_BLOCK(ELEMENT, in, out, reads, writes, scalar, lines, N - lines);
+      }
+    }
+    _Pragma("omp barrier") _Pragma("omp single") E = getTimeStamp();
+  }
+
+  return E - S;
+}
+
+#undef FN
+#undef ELEMENT
+#undef CONST_ARRAY
+#undef INPUT
+#undef INPUT_INDEX
+#undef SCALAR
+#undef HARNESS
+#undef PRIVATE
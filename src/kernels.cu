@@ -219,6 +219,12 @@ __global__ void sumCuda(
   return E - S;
 
 extern "C" {
+// The store instructions are left to the CUDA compiler
+int useStreamingStores(const size_t bytes)
+{
+  return 0;
+}
+
 void allocateArrays(double **a, double **b, double **c, double **d, const size_t N)
 {
   GPU_ERROR(cudaSetDevice(CUDA_DEVICE));
@@ -4,9 +4,29 @@
  * license that can be found in the LICENSE file. */
 #ifndef KERNELS_H_
 #define KERNELS_H_
+#include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
 
+#include "util.h"
+
+#define CACHELINE_SIZE 64
+
+/* Cache line sized node for the pointer chasing latency kernel */
+typedef struct node {
+  struct node *next;
+  char pad[CACHELINE_SIZE - sizeof(struct node *)];
+} node;
+
+/* Delay value for loadedLatency running the chase without any load */
+#define LOADED_IDLE ((size_t)-1)
+/* Number of elements streamed between two delay injections */
+#define LOADED_BLOCKSIZE 512
+
+/* Number of nodes in a chain occupying the memory of N doubles */
+#define chainLength(N) MAX((N) * sizeof(double) / CACHELINE_SIZE, 2)
+
+extern int useStreamingStores(size_t bytes);
 extern void allocateArrays(double **a, double **b, double **c, double **d, size_t N);
 extern void initArrays(double *a, double *b, double *c, double *d, size_t N);
 extern double init(double *a, double scalar, size_t N);
@@ -18,6 +38,12 @@ extern double striad(
     double *a, const double *b, const double *c, const double *d, size_t N);
 extern double daxpy(double *a, const double *b, double scalar, size_t N);
 extern double sdaxpy(double *a, const double *b, const double *c, size_t N);
+extern double strided(double *a, const double *b, size_t N, size_t stride);
+extern double gather(double *a, const double *b, const uint32_t *index, size_t N);
+extern double scatter(double *a, const double *b, const uint32_t *index, size_t N);
+extern double stencil2d(double *a, const double *b, double weight, size_t N);
+extern double stencil3d(double *a, const double *b, double weight, size_t N);
+extern double streams(int reads, int writes, double scalar, size_t N);
 
 #ifndef _NVCC
 extern double init_seq(double *a, double scalar, size_t N, size_t iter);
@@ -31,7 +57,22 @@ extern double striad_seq(
 extern double daxpy_seq(double *a, const double *b, double scalar, size_t N, size_t iter);
 extern double sdaxpy_seq(
     double *a, const double *b, const double *c, size_t N, size_t iter);
+extern double strided_seq(
+    double *a, const double *b, size_t N, size_t stride, size_t iter);
+extern double gather_seq(
+    double *a, const double *b, const uint32_t *index, size_t N, size_t iter);
+extern double scatter_seq(
+    double *a, const double *b, const uint32_t *index, size_t N, size_t iter);
+extern double stencil2d_seq(
+    double *a, const double *b, double weight, size_t N, size_t iter);
+extern double stencil3d_seq(
+    double *a, const double *b, double weight, size_t N, size_t iter);
+extern double streams_seq(int reads, int writes, double scalar, size_t N, size_t iter);
+extern void initChain(node *chain, size_t numNodes, unsigned int seed);
+extern double latency_seq(double *a, size_t N, size_t iter);
 
+extern void allocateArena(size_t bytes);
+extern void freeArena(void);
 extern double init_tp(double *a, double scalar, size_t N, size_t iter);
 extern double update_tp(const double *a, double scalar, size_t N, size_t iter);
 extern double sum_tp(const double *a, size_t N, size_t iter);
@@ -44,5 +85,27 @@ extern double daxpy_tp(
     const double *a, const double *b, double scalar, size_t N, size_t iter);
 extern double sdaxpy_tp(
     const double *a, const double *b, const double *c, size_t N, size_t iter);
+extern double strided_tp(
+    double *a, const double *b, size_t N, size_t stride, size_t iter);
+extern double gather_tp(
+    double *a, const double *b, const uint32_t *index, size_t N, size_t iter);
+extern double scatter_tp(
+    double *a, const double *b, const uint32_t *index, size_t N, size_t iter);
+extern double stencil2d_tp(
+    double *a, const double *b, double weight, size_t N, size_t iter);
+extern double stencil3d_tp(
+    double *a, const double *b, double weight, size_t N, size_t iter);
+extern double streams_tp(int reads, int writes, double scalar, size_t N, size_t iter);
+extern double latency_tp(size_t N, size_t iter);
+
+extern double loadedLatency(double *a,
+    const double *b,
+    const double *c,
+    double *d,
+    size_t N,
+    int kernel,
+    size_t delay,
+    size_t loads,
+    size_t *elements);
 #endif
 #endif
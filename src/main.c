@@ -7,42 +7,85 @@
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #ifdef _OPENMP
-#include "affinity.h"
 #include <omp.h>
 #endif
 
+#include "affinity.h"
+#include "allocate.h"
+#include "barrier.h"
+#include "baseline.h"
 #include "cli.h"
+#include "indices.h"
+#include "isa.h"
 #include "kernels.h"
+#include "numa.h"
+#include "output.h"
+#include "perfctr.h"
 #include "profiler.h"
+#include "streams.h"
+#include "timing.h"
+#include "topology.h"
 #include "util.h"
 
-static void check(
-    const double *, const double *, const double *, const double *, size_t, size_t);
-static void kernelSwitch(double *,
+// Dependent loads per measurement and number of delay steps in loaded mode
+#define LOADED_LOADS (1ull << 22)
+#define LOADED_STEPS 16
+// Minimum run time of a sweep point in seconds
+#define SWEEP_MINTIME 1.0E-03
+
+static void check(const double *,
     const double *,
     const double *,
     const double *,
     double,
     size_t,
+    size_t);
+static void loadedSweep(double *, double *, double *, double *, size_t);
+#ifndef _NVCC
+static size_t calibrate(sweepKernel,
+    double *,
+    double *,
+    double *,
+    double *,
+    double,
     size_t,
+    size_t);
+static void runPersistent(double *, double *, double *, double *, double, size_t);
+static void scalingSweep(double *, double *, double *, double *, double, size_t);
+static void prefetchSweep(double *, double *, double *, double *, double, size_t);
+static void prefetchPoint(sweepKernel,
+    int,
+    double *,
+    double *,
+    double *,
+    double *,
+    double,
     size_t,
-    int);
+    size_t);
+static size_t footprint(int);
+#endif
 
 int main(const int argc, char **argv)
 {
-  const size_t bytesPerWord = sizeof(double);
-
   // Data initialization from config.mk
   N     = SIZE;
   ITERS = NTIMES;
 
-  // ensure N is divisible by 8
+  double *a, *b, *c, *d;
+
+  profilerInit();
+
+  parseCLI(argc, argv);
+  affinity_pinThreads();
+
+  // ensure N is divisible by 32, the widest unrolling of the kernel variants
   size_t num_threads = 1;
 
 #ifdef _OPENMP
@@ -53,17 +96,13 @@ int main(const int argc, char **argv)
   }
 #endif
 
-  const int base = (N + num_threads - 1) / num_threads;
-  N              = ((base + 7) & ~7) * num_threads;
-
-  double *a, *b, *c, *d;
-
-  profilerInit();
-
-  parseCLI(argc, argv);
+  const size_t base = (N + num_threads - 1) / num_threads;
+  N                 = ((base + 31) & ~31) * num_threads;
 
   allocateTimer();
 
+  const size_t bytesPerWord = registry_getArrayWordSize();
+
   printf("\n");
   printf(BANNER);
   printf(HLINE);
@@ -92,124 +131,413 @@ int main(const int argc, char **argv)
   SEQ = 1;
 #endif
 
+#ifndef _NVCC
+  if (data_type != DT_DOUBLE) {
+    if (kernel_isa != ISA_AUTO && kernel_isa != ISA_COMPILER) {
+      fprintf(stderr,
+          "Error: Kernel variant %s is only available for double\n",
+          isa_getName(kernel_isa));
+      exit(EXIT_FAILURE);
+    }
+    kernel_isa = ISA_COMPILER;
+    printf("Kernel variant: %s (%s)\n",
+        isa_getName(kernel_isa),
+        dataTypeNames[data_type]);
+  } else if (kernel_isa == ISA_AUTO) {
+    kernel_isa = isa_detect();
+    printf("Kernel variant: %s (detected)\n", isa_getName(kernel_isa));
+  } else if (isa_isSupported(kernel_isa)) {
+    printf("Kernel variant: %s\n", isa_getName(kernel_isa));
+  } else {
+    fprintf(stderr,
+        "Error: Kernel variant %s is not supported\n",
+        isa_getName(kernel_isa));
+    exit(EXIT_FAILURE);
+  }
+
+  if (store_mode != STORES_REGULAR && !useStreamingStores(SIZE_MAX)) {
+    printf("Warning: Non-temporal stores are not available, using regular stores\n");
+    store_mode = STORES_REGULAR;
+  }
+
+  if ((prefetch_distance > 0 || prefetch_sweep) && (type == TP || type == LOADED)) {
+    printf("Warning: Software prefetch is only available in ws, seq and scaling mode\n");
+    prefetch_distance = 0;
+    prefetch_sweep    = 0;
+  }
+  if (prefetch_sweep && type == SCALING) {
+    printf("Warning: The prefetch distance sweep is not available in scaling mode\n");
+    prefetch_sweep = 0;
+  }
+  if (prefetch_sweep) {
+    printf("Software prefetch: distance sweep, hint %s\n",
+        prefetchHintNames[prefetch_hint]);
+  } else if (prefetch_distance > 0) {
+    printf("Software prefetch: %zu B ahead, hint %s\n",
+        prefetch_distance,
+        prefetchHintNames[prefetch_hint]);
+  }
+#else
+  if (data_type != DT_DOUBLE) {
+    fprintf(stderr, "Error: GPU kernels are only available for double\n");
+    exit(EXIT_FAILURE);
+  }
+  if (persistent) {
+    printf("Warning: The persistent parallel region is not available on GPUs\n");
+    persistent = 0;
+  }
+  if (perf_counters) {
+    printf("Warning: Hardware counters are not available on GPUs\n");
+    perf_counters = 0;
+  }
+  if (prefetch_distance > 0 || prefetch_sweep) {
+    printf("Warning: Software prefetch is not available on GPUs\n");
+  }
+#endif
+
   allocateArrays(&a, &b, &c, &d, N);
   initArrays(a, b, c, d, N);
 
-  const double scalar = 0.1;
+#ifndef _NVCC
+  printf(HLINE);
+  numa_printPlacement();
+  numa_printPageDistribution("Array a", a, N * bytesPerWord);
+  numa_printPageDistribution("Array b", b, N * bytesPerWord);
+  numa_printPageDistribution("Array c", c, N * bytesPerWord);
+  numa_printPageDistribution("Array d", d, N * bytesPerWord);
+  printPageType();
+  printPageInfo("Array a", a);
+  printPageInfo("Array b", b);
+  printPageInfo("Array c", c);
+  printPageInfo("Array d", d);
+#endif
+
+  // 0.1 would truncate to 0 in the integer types
+  const double scalar = INTEGER_TYPE(data_type) ? 3.0 : 0.1;
+
+  if (registry_isSelected(registry_find("Gather")) ||
+      registry_isSelected(registry_find("Scatter"))) {
+    index_printType();
+  }
+  if (registry_isSelected(registry_find("Streams"))) {
+    streams_print(N);
+  }
 
 #ifndef _NVCC
+  if (type == LOADED) {
+    if (output_format != OUTPUT_TEXT) {
+      printf("Warning: Structured output is not available in loaded mode\n");
+    }
+    loadedSweep(a, b, c, d, N);
+    exit(EXIT_SUCCESS);
+  }
+  if (type == SCALING) {
+    if (output_format != OUTPUT_TEXT) {
+      printf("Warning: Structured output is not available in scaling mode\n");
+    }
+    scalingSweep(a, b, c, d, scalar, N);
+    exit(EXIT_SUCCESS);
+  }
+  if (prefetch_sweep && type == WS) {
+    if (output_format != OUTPUT_TEXT) {
+      printf("Warning: Structured output is not available in the prefetch sweep\n");
+    }
+    if (persistent) {
+      printf("Warning: The persistent parallel region is not used in the prefetch "
+             "sweep\n");
+      persistent = 0;
+    }
+    prefetchSweep(a, b, c, d, scalar, N);
+    exit(EXIT_SUCCESS);
+  }
+#endif
+
+  output_open();
+
+#ifndef _NVCC
+
+  if (private_inputs && type != TP) {
+    printf("Warning: Private input arrays are only used in tp mode\n");
+  }
+  if (baseline_isLoaded() && type != WS) {
+    printf("Warning: The baseline comparison is only available in ws mode\n");
+  }
+  if (persistent && type != WS) {
+    printf("Warning: The persistent parallel region is only used in ws mode\n");
+  }
+  if (perf_counters && (type != WS || persistent)) {
+    printf("Warning: Hardware counters are only measured in ws mode without "
+           "--persistent\n");
+  }
+
   if (type == TP || type == SQ) {
+    const size_t size = N;
+
     printf("Running memory hierarchy sweeps\n");
+    topology_init();
+    topology_print();
+    // Only the cycles are counted, for the frequency at every size
+    perfctr_init(0);
+    if (!SEQ) {
+      if (private_inputs) {
+        printf("Thread private input arrays\n");
+      }
+      allocateArena(size * sizeof(double));
+    }
+
+    int threads = 1;
+#ifdef _OPENMP
+    if (!SEQ) {
+      threads = omp_get_max_threads();
+    }
+#endif
+
+    for (int j = 0; j < numKernels; j++) {
+      const sweepKernel kernel = SEQ ? _kernels[j].seq : _kernels[j].tp;
+
+      if (!registry_isSelected(j)) {
+        continue;
+      }
 
-    for (int j = 0; j < NUMREGIONS; j++) {
-      N = 100;
+      size_t iter = 1;
+      N           = 100;
+
+      const int prefetch = prefetch_sweep && registry_hasPrefetch(j);
 
       profilerOpenFile(j);
+      if (prefetch) {
+        profilerOpenPrefetchFile(j);
+      }
+
+      while (N < size) {
+        if (_kernels[j].setup != NULL) {
+          _kernels[j].setup(a, N);
+        }
 
-      while (N < SIZE) {
+        iter = calibrate(kernel, a, b, c, d, scalar, N, iter);
 
-        double newtime = 0.0;
-        double oldtime = 0.0;
-        size_t iter    = 2;
+        const double start = getTimeStamp();
+        size_t runs        = 0;
 
-        while (newtime < 0.3) {
-          newtime = striad_seq(a, b, c, d, N, iter);
-          if (newtime > 0.1) {
+        perfctr_reset(j);
+        while (runs < ITERS) {
+          perfctr_start();
+          _t[j][runs] = kernel(a, b, c, d, scalar, N, iter);
+          perfctr_stop(j, runs++);
+          if (profilerIsConverged(j, runs, start)) {
             break;
           }
-          if ((newtime - oldtime) > 0.0) {
-            const double factor = 0.3 / (newtime - oldtime);
-            iter *= (int)factor;
-            oldtime = newtime;
-          }
         }
 
-        kernelSwitch(a, b, c, d, scalar, N, ITERS, iter, j);
+        profilerPrintLine(N, iter, runs, j);
+        if (prefetch) {
+          prefetchPoint(kernel, j, a, b, c, d, scalar, N, iter);
+        }
 
-        profilerPrintLine(N, iter, j);
-        N = ((double)N * 1.2);
+        // The time per iteration grows about linearly with N
+        const size_t next = topology_nextSize(N, footprint(j), threads);
+        iter              = MAX(iter * N / next, 1);
+        N                 = next;
       }
 
       profilerCloseFile();
+      if (prefetch) {
+        profilerClosePrefetchFile();
+      }
+    }
+    if (!SEQ) {
+      freeArena();
     }
+    output_close();
     exit(EXIT_SUCCESS);
   }
 #endif
 
-  for (int k = 0; k < ITERS; k++) {
+  // The layer condition of the stencils depends on the cache sizes
+  topology_init();
 
-    PROFILE(INIT, init(b, scalar, N));
-#ifdef _NVCC
-    PROFILE(SUM, sum(a, N));
-#else
-    const double tmp = a[10];
-    PROFILE(SUM, sum(a, N));
-    a[10] = tmp;
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws != NULL && _kernels[j].setup != NULL && registry_isSelected(j)) {
+      _kernels[j].setup(a, N);
+    }
+  }
+
+  if (!persistent && perfctr_init(perf_counters) != 0 && perf_counters) {
+    printf("Warning: No hardware counters accessible, check perf_event_paranoid\n");
+  }
+
+  const double start = getTimeStamp();
+
+#ifndef _NVCC
+  if (persistent) {
+    printf("Persistent parallel region\n");
+    runPersistent(a, b, c, d, scalar, N);
+  }
 #endif
-    PROFILE(COPY, copy(c, a, N));
-    PROFILE(UPDATE, update(a, scalar, N));
-    PROFILE(TRIAD, triad(a, b, c, scalar, N));
-    PROFILE(DAXPY, daxpy(a, b, scalar, N));
-    PROFILE(STRIAD, striad(a, b, c, d, N));
-    PROFILE(SDAXPY, sdaxpy(a, b, c, N));
+
+  for (int k = 0; k < ITERS && !persistent; k++) {
+    for (int j = 0; j < numKernels; j++) {
+      if (_kernels[j].ws != NULL && registry_isSelected(j)) {
+        PROFILE(j, _kernels[j].ws(a, b, c, d, scalar, N));
+      }
+    }
+    // All kernels run the same number of times, check() replays ITERS runs
+    if (profilerIsConverged(-1, k + 1, start)) {
+      ITERS = k + 1;
+      break;
+    }
   }
 
 #ifndef _NVCC
-  check(a, b, c, d, N, ITERS);
+  check(a, b, c, d, scalar, N, ITERS);
 #endif
   profilerPrint(N);
+  output_close();
 
   freeTimer();
 
+  if (baseline_getVerdict() == VERDICT_FAIL) {
+    return BASELINE_EXIT_REGRESSION;
+  }
+
   return EXIT_SUCCESS;
 }
 
+// Sum of the first N elements of x in the element type, integers wrap around
+#define SUM_INTEGER(T, x) SUM_ELEMENTS(T, x, uint64_t)
+#define SUM_FP(T, x) SUM_ELEMENTS(T, x, double)
+#define SUM_ELEMENTS(T, x, S)                                                            \
+  {                                                                                      \
+    S s = 0;                                                                             \
+    for (size_t i = 0; i < N; i++) {                                                     \
+      s += ((const T *)x)[i];                                                            \
+    }                                                                                    \
+    sum = (T)s;                                                                          \
+  }
+
+/* Replays the selected kernels on the initial values in uint64_t arithmetic.
+ * Reducing to the element type after every kernel gives the wrap around of the
+ * integer kernels. The elements written by Stride are replayed separately. */
+static int checkInteger(const double *const arrays[4],
+    const double scalar,
+    const size_t N,
+    const size_t ITERS)
+{
+  const uint64_t mask    = data_type == DT_INT32 ? UINT32_MAX : UINT64_MAX;
+  const uint64_t strided = N / STRIDE;
+  uint64_t v[2][4]       = { { 2, 2, 1, 1 }, { 2, 2, 1, 1 } };
+
+  for (size_t k = 0; k < ITERS; k++) {
+    for (int j = 0; j < numKernels; j++) {
+      if (_kernels[j].model == NULL || !registry_isSelected(j)) {
+        continue;
+      }
+      for (int e = _kernels[j].model->strided; e < 2; e++) {
+        _kernels[j].model->integer(
+            &v[e][0], &v[e][1], &v[e][2], &v[e][3], (uint64_t)scalar);
+        for (int x = 0; x < 4; x++) {
+          v[e][x] &= mask;
+        }
+      }
+    }
+  }
+
+  for (int x = 0; x < 4; x++) {
+    const uint64_t expected = (v[0][x] * (N - strided) + v[1][x] * strided) & mask;
+    uint64_t sum;
+
+    if (data_type == DT_INT32) {
+      SUM_INTEGER(uint32_t, arrays[x])
+    } else {
+      SUM_INTEGER(uint64_t, arrays[x])
+    }
+    if (sum != expected) {
+      printf("Failed Validation on array %c[]\n", 'a' + x);
+      printf("        Expected  : %llu \n", (unsigned long long)expected);
+      printf("        Observed  : %llu \n", (unsigned long long)sum);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
 void check(const double *a,
     const double *b,
     const double *c,
     const double *d,
+    const double scalar,
     const size_t N,
     const size_t ITERS)
 {
   if (data_init_type == 1) {
+    printf("Validation skipped for random initialization\n");
+    return;
+  }
+
+  if (INTEGER_TYPE(data_type)) {
+    // The stencil weights truncate to 0, the result is not the mean
+    if (registry_isSelected(registry_find("Stencil2D")) ||
+        registry_isSelected(registry_find("Stencil3D"))) {
+      printf("Validation skipped, the stencils are not validated for %s\n",
+          dataTypeNames[data_type]);
+      return;
+    }
+
+    const double *const arrays[4] = { a, b, c, d };
+    if (checkInteger(arrays, scalar, N, ITERS)) {
+      printf("Solution Validates\n");
+    }
     return;
   }
 
   double epsilon;
 
-  /* reproduce initialization */
-  double aj = 2.0;
-  double bj = 2.0;
-  double cj = 0.5;
-  double dj = 1.0;
+  /* reproduce initialization, the second set are the elements written by
+   * Stride, which are replayed separately */
+  double v[2][4]       = { { 2.0, 2.0, 0.5, 1.0 }, { 2.0, 2.0, 0.5, 1.0 } };
+  const size_t strided = N / STRIDE;
 
   /* now execute timing loop */
   for (int k = 0; k < ITERS; k++) {
-    const double scalar = 0.1;
-    bj                  = scalar;
-    cj                  = aj;
-    aj                  = aj * scalar;
-    aj                  = bj + scalar * cj;
-    aj                  = aj + scalar * bj;
-    aj                  = bj + cj * dj;
-    aj                  = aj + bj * cj;
+    for (int j = 0; j < numKernels; j++) {
+      if (_kernels[j].model == NULL || !registry_isSelected(j)) {
+        continue;
+      }
+      for (int e = _kernels[j].model->strided; e < 2; e++) {
+        _kernels[j].model->fp(&v[e][0], &v[e][1], &v[e][2], &v[e][3], scalar);
+      }
+    }
   }
 
-  aj          = aj * (double)(N);
-  bj          = bj * (double)(N);
-  cj          = cj * (double)(N);
-  dj          = dj * (double)(N);
+  double aj = v[0][0] * (double)(N - strided) + v[1][0] * (double)strided;
+  double bj = v[0][1] * (double)(N - strided) + v[1][1] * (double)strided;
+  double cj = v[0][2] * (double)(N - strided) + v[1][2] * (double)strided;
+  double dj = v[0][3] * (double)(N - strided) + v[1][3] * (double)strided;
 
   double asum = 0.0;
   double bsum = 0.0;
   double csum = 0.0;
   double dsum = 0.0;
 
-  for (size_t i = 0; i < N; i++) {
-    asum += a[i];
-    bsum += b[i];
-    csum += c[i];
-    dsum += d[i];
+  if (data_type == DT_FLOAT) {
+    double sum;
+
+    SUM_FP(float, a)
+    asum = sum;
+    SUM_FP(float, b)
+    bsum = sum;
+    SUM_FP(float, c)
+    csum = sum;
+    SUM_FP(float, d)
+    dsum = sum;
+  } else {
+    for (size_t i = 0; i < N; i++) {
+      asum += a[i];
+      bsum += b[i];
+      csum += c[i];
+      dsum += d[i];
+    }
   }
 
 #ifdef VERBOSE
@@ -218,7 +546,8 @@ void check(const double *a,
   printf("        Observed  : %f %f %f \n", asum, bsum, csum);
 #endif
 
-  epsilon = 1.e-8;
+  // The float kernels round every operation to single precision
+  epsilon = data_type == DT_FLOAT ? 1.e-4 : 1.e-8;
 
   if (ABS(aj - asum) / asum > epsilon) {
     printf("Failed Validation on array a[]\n");
@@ -242,113 +571,338 @@ void check(const double *a,
 }
 
 #ifndef _NVCC
-void kernelSwitch(double *restrict a,
-    const double *restrict b,
-    const double *restrict c,
-    const double *restrict d,
+/* Latency of thread 0 while all other threads run the load kernel. The delay
+ * injected by the load threads is decreased step by step from idle to full
+ * load, giving the latency vs. bandwidth curve. */
+static void loadedSweep(double *restrict a,
+    double *restrict b,
+    double *restrict c,
+    double *restrict d,
+    const size_t N)
+{
+  int num_threads = 1;
+  size_t elements;
+
+#ifdef _OPENMP
+#pragma omp parallel
+  {
+#pragma omp single
+    num_threads = omp_get_num_threads();
+  }
+#endif
+
+  if (num_threads < 2) {
+    fprintf(stderr, "Error: Loaded latency mode requires at least 2 threads\n");
+    exit(EXIT_FAILURE);
+  }
+  // Every load thread needs at least one block of its own
+  if (N / (num_threads - 1) < LOADED_BLOCKSIZE) {
+    fprintf(stderr,
+        "Error: Array size too small for loaded latency mode, at least %zu "
+        "elements are required\n",
+        (size_t)(num_threads - 1) * LOADED_BLOCKSIZE);
+    exit(EXIT_FAILURE);
+  }
+
+  initChain((node *)d, chainLength(N), 1);
+  profilerOpenLoadedFile(load_kernel, num_threads - 1);
+
+  double time = loadedLatency(
+      a, b, c, d, N, load_kernel, LOADED_IDLE, LOADED_LOADS, &elements);
+  profilerPrintLoadedLine(LOADED_IDLE, elements, time, LOADED_LOADS, load_kernel);
+
+  for (int step = LOADED_STEPS; step >= 0; step--) {
+    const size_t delay = step ? 1ull << (step - 1) : 0;
+
+    time = loadedLatency(
+        a, b, c, d, N, load_kernel, delay, LOADED_LOADS, &elements);
+    profilerPrintLoadedLine(delay, elements, time, LOADED_LOADS, load_kernel);
+  }
+
+  printf(HLINE);
+  profilerCloseFile();
+}
+
+// Thread count following threads in the sequence 1, step, 2 * step, ..., max
+static int nextThreads(const int threads, const int maxThreads)
+{
+  if (threads == maxThreads) {
+    return maxThreads + 1;
+  }
+
+  return MIN(threads - threads % scaling_step + scaling_step, maxThreads);
+}
+
+/* Runs the ws kernels on the same arrays with 1, step, 2 * step, ... threads
+ * up to the number of threads at startup. The threads of every team are pinned
+ * in order to the processors of the pin expression, by default no-smt, which
+ * fills the cores of a NUMA node before the next one. With first touch
+ * placement every thread moves the pages of its part of the arrays to its node
+ * before the runs, the static schedule of the kernels gives that part. */
+static void scalingSweep(double *restrict a,
+    double *restrict b,
+    double *restrict c,
+    double *restrict d,
     const double scalar,
-    const size_t N,
-    const size_t ITERS,
-    const size_t iter,
-    const int j)
+    const size_t N)
 {
-  switch (j) {
-  case INIT:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[INIT][k] = init_seq(a, scalar, N, iter);
-      }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[INIT][k] = init_tp(a, scalar, N, iter);
-      }
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  int maxThreads            = 1;
+  size_t totalRuns          = 0;
+
+#ifdef _OPENMP
+  maxThreads = omp_get_max_threads();
+#endif
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws != NULL && _kernels[j].setup != NULL && registry_isSelected(j)) {
+      _kernels[j].setup(a, N);
     }
-    break;
+  }
+  profilerOpenScalingFile(N);
 
-  case SUM:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[SUM][k] = sum_seq(a, N, iter);
-      }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[SUM][k] = sum_tp(a, N, iter);
+  for (int threads = 1; threads <= maxThreads;
+       threads = nextThreads(threads, maxThreads)) {
+    int failed = 0;
+    int moved  = 0;
+
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#pragma omp parallel reduction(+ : failed, moved)
+    {
+      const size_t chunk = (N + threads - 1) / threads;
+      const size_t begin = MIN(omp_get_thread_num() * chunk, N);
+      const size_t bytes = MIN(chunk, N - begin) * bytesPerWord;
+
+      failed += affinity_pinTeam() != 0;
+      if (placement == FIRSTTOUCH) {
+        moved += numa_moveLocal((char *)a + begin * bytesPerWord, bytes) != 0;
+        moved += numa_moveLocal((char *)b + begin * bytesPerWord, bytes) != 0;
+        moved += numa_moveLocal((char *)c + begin * bytesPerWord, bytes) != 0;
+        moved += numa_moveLocal((char *)d + begin * bytesPerWord, bytes) != 0;
       }
     }
-    break;
+#endif
+    if (failed > 0) {
+      printf("Warning: Pinning failed for %d of %d threads\n", failed, threads);
+    }
+    if (moved > 0) {
+      printf("Warning: Page migration failed for %d of %d threads\n", moved, threads);
+    }
 
-  case COPY:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[COPY][k] = copy_seq(a, b, N, iter);
+    const double start = getTimeStamp();
+    size_t runs        = ITERS;
+
+    for (int k = 0; k < ITERS; k++) {
+      for (int j = 0; j < numKernels; j++) {
+        if (_kernels[j].ws != NULL && registry_isSelected(j)) {
+          PROFILE(j, _kernels[j].ws(a, b, c, d, scalar, N));
+        }
       }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[COPY][k] = copy_tp(a, b, N, iter);
+      if (profilerIsConverged(-1, k + 1, start)) {
+        runs = k + 1;
+        break;
       }
     }
-    break;
 
-  case UPDATE:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[UPDATE][k] = update_seq(a, scalar, N, iter);
-      }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[UPDATE][k] = update_tp(a, scalar, N, iter);
-      }
+    profilerPrintScalingLine(threads, N, runs);
+    totalRuns += runs;
+  }
+
+#ifdef _OPENMP
+  omp_set_num_threads(maxThreads);
+#endif
+  printf(HLINE);
+  profilerCloseFile();
+  check(a, b, c, d, scalar, N, totalRuns);
+}
+
+/* Runs the selected ws kernels with a prefetch variant at every distance of the
+ * prefetch sweep on N elements. The other kernels do not run, hence there is no
+ * validation, the prefetch variants are validated in the regular ws mode. */
+static void prefetchSweep(double *restrict a,
+    double *restrict b,
+    double *restrict c,
+    double *restrict d,
+    const double scalar,
+    const size_t N)
+{
+  double times[NUMPREFETCHDISTANCES];
+
+  profilerOpenPrefetchFile(-1);
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j) || !registry_hasPrefetch(j)) {
+      continue;
     }
-    break;
 
-  case TRIAD:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[TRIAD][k] = triad_seq(a, b, c, scalar, N, iter);
-      }
-    } else {
+    for (int p = 0; p < NUMPREFETCHDISTANCES; p++) {
+      const double start = getTimeStamp();
+      size_t runs        = ITERS;
+
+      prefetch_distance = prefetchDistances[p];
       for (int k = 0; k < ITERS; k++) {
-        _t[TRIAD][k] = triad_tp(a, b, c, scalar, N, iter);
+        PROFILE(j, _kernels[j].ws(a, b, c, d, scalar, N));
+        if (profilerIsConverged(j, k + 1, start)) {
+          runs = k + 1;
+          break;
+        }
       }
+      times[p] = profilerGetMinTime(j, runs);
     }
-    break;
 
-  case DAXPY:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[DAXPY][k] = daxpy_seq(a, b, scalar, N, iter);
-      }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[DAXPY][k] = daxpy_tp(a, b, scalar, N, iter);
+    profilerPrintPrefetchLine(j, N, 1, times);
+  }
+
+  prefetch_distance = 0;
+  printf(HLINE);
+  profilerClosePrefetchFile();
+}
+
+/* Runs kernel j of a seq sweep with iter iterations on N elements at every
+ * distance of the prefetch sweep, the runs overwrite the times of the regular
+ * run of that size */
+static void prefetchPoint(const sweepKernel kernel,
+    const int j,
+    double *restrict a,
+    double *restrict b,
+    double *restrict c,
+    double *restrict d,
+    const double scalar,
+    const size_t N,
+    const size_t iter)
+{
+  double times[NUMPREFETCHDISTANCES];
+
+  for (int p = 0; p < NUMPREFETCHDISTANCES; p++) {
+    const double start = getTimeStamp();
+    size_t runs        = 0;
+
+    prefetch_distance = prefetchDistances[p];
+    while (runs < ITERS) {
+      _t[j][runs] = kernel(a, b, c, d, scalar, N, iter);
+      if (profilerIsConverged(j, ++runs, start)) {
+        break;
       }
     }
-    break;
+    times[p] = profilerGetMinTime(j, runs);
+  }
 
-  case STRIAD:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[STRIAD][k] = striad_seq(a, b, c, d, N, iter);
-      }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[STRIAD][k] = striad_tp(a, b, c, d, N, iter);
-      }
+  prefetch_distance = 0;
+  profilerPrintPrefetchLine(j, N, iter, times);
+}
+
+/* Number of iterations of kernel on N elements for a run time of
+ * sweep_time / ITERS, at least SWEEP_MINTIME. Starts from guess, usually the
+ * scaled result of the previous N, which mostly requires a single timing after
+ * a warm-up run. */
+static size_t calibrate(const sweepKernel kernel,
+    double *restrict a,
+    double *restrict b,
+    double *restrict c,
+    double *restrict d,
+    const double scalar,
+    const size_t N,
+    const size_t guess)
+{
+  const double target = MAX(sweep_time / (double)ITERS, SWEEP_MINTIME);
+  size_t iter         = MAX(guess, 1);
+
+  // The first run after a change of N is slower, e.g. due to cold caches
+  kernel(a, b, c, d, scalar, N, iter);
+
+  for (;;) {
+    const double time = kernel(a, b, c, d, scalar, N, iter);
+
+    // Too short runs are dominated by the timer, scale up and time again
+    if (time < 0.1 * target) {
+      iter = time > 0.0 ? (size_t)((double)iter * target / time) + 1 : iter * 10;
+      continue;
     }
-    break;
 
-  case SDAXPY:
-    if (SEQ) {
-      for (int k = 0; k < ITERS; k++) {
-        _t[SDAXPY][k] = sdaxpy_seq(a, b, c, N, iter);
+    return MAX((size_t)((double)iter * target / time + 0.5), 1);
+  }
+}
+#endif
+
+/* Runs the ws repetitions in a single parallel region instead of one region per
+ * kernel run. The kernels are the persistent variants without parallel region,
+ * the threads synchronize with a spin barrier before and after every kernel and
+ * thread 0 takes the time stamps. done changes once and only before the barrier
+ * at the end of a repetition, the kernel barriers keep the threads from reading
+ * it early. */
+static void runPersistent(double *restrict a,
+    double *restrict b,
+    double *restrict c,
+    double *restrict d,
+    const double scalar,
+    const size_t N)
+{
+  const double start = getTimeStamp();
+  spinBarrier barrier;
+  size_t runs = ITERS;
+  int done    = 0;
+  int kernels = 0;
+
+  for (int j = 0; j < numKernels; j++) {
+    kernels += _kernels[j].ws != NULL && registry_isSelected(j);
+  }
+  if (kernels == 0) {
+    return;
+  }
+  barrier_init(&barrier, 1);
+
+#pragma omp parallel
+  {
+    int sense = 0;
+    int id    = 0;
+#ifdef _OPENMP
+    id = omp_get_thread_num();
+#pragma omp single
+    barrier_init(&barrier, omp_get_num_threads());
+#endif
+
+    for (size_t k = 0; k < ITERS && !done; k++) {
+      for (int j = 0; j < numKernels; j++) {
+        if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+          continue;
+        }
+
+        LIKWID_MARKER_START(_kernels[j].tag);
+        barrier_wait(&barrier, &sense);
+        const double S = getTimeStamp();
+        _kernels[j].ws(a, b, c, d, scalar, N);
+        barrier_wait(&barrier, &sense);
+        if (id == 0) {
+          _t[j][k] = getTimeStamp() - S;
+          profilerRecordThreads(j, k);
+        }
+        LIKWID_MARKER_STOP(_kernels[j].tag);
       }
-    } else {
-      for (int k = 0; k < ITERS; k++) {
-        _t[SDAXPY][k] = sdaxpy_tp(a, b, c, N, iter);
+
+      if (id == 0 && profilerIsConverged(-1, k + 1, start)) {
+        runs = k + 1;
+        done = 1;
       }
+      barrier_wait(&barrier, &sense);
     }
-    break;
-  default:;
   }
+
+  ITERS = runs;
+}
+
+/* Bytes of all arrays of kernel j per element, which decides the array size
+ * at which the working set exceeds a cache */
+size_t footprint(const int j)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+
+  if (_kernels[j].latency) {
+    return sizeof(double);
+  }
+  if (_kernels[j].pattern == PATTERN_GATHER || _kernels[j].pattern == PATTERN_SCATTER) {
+    return (_kernels[j].loads + _kernels[j].stores) * bytesPerWord + sizeof(uint32_t);
+  }
+
+  return (_kernels[j].loads + _kernels[j].stores) * bytesPerWord;
 }
-#endif
@@ -0,0 +1,283 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cli.h"
+#include "numa.h"
+#include "util.h"
+
+static const char *placementNames[NUMPLACEMENTS] = {
+  "firsttouch",
+  "local",
+  "interleave",
+  "node",
+};
+
+int numa_parsePlacement(const char *arg)
+{
+  if (strncmp(arg, "node:", 5) == 0) {
+    char *end;
+    errno          = 0;
+    const long val = strtol(arg + 5, &end, 10);
+    if (arg[5] == '\0' || *end != '\0' || errno != 0 || val < 0) {
+      return -1;
+    }
+    placement      = NODE;
+    placement_node = (int)val;
+    return 0;
+  }
+
+  for (int i = 0; i < NUMPLACEMENTS; i++) {
+    if (i != NODE && strcmp(arg, placementNames[i]) == 0) {
+      placement = i;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+#ifdef __linux__
+
+#include <sys/syscall.h>
+
+/* Kernel ABI values from linux/mempolicy.h, no libnuma required */
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+#define MPOL_MF_MOVE (1 << 1)
+
+#define MAXNODES 1024
+#define MASKBITS (8 * sizeof(unsigned long))
+#define MASKWORDS (MAXNODES / MASKBITS)
+#define SAMPLEPAGES 4096
+
+static void setNode(unsigned long *mask, const int node)
+{
+  mask[node / MASKBITS] |= 1UL << (node % MASKBITS);
+}
+
+static int isNodeSet(const unsigned long *mask, const int node)
+{
+  return (mask[node / MASKBITS] >> (node % MASKBITS)) & 1UL;
+}
+
+/* Parse a sysfs list like "0-3,6" into a node mask, returns number of nodes */
+static int readNodeList(unsigned long *mask)
+{
+  char line[4096];
+  FILE *fp = fopen("/sys/devices/system/node/has_memory", "r");
+
+  if (fp == NULL) {
+    fp = fopen("/sys/devices/system/node/online", "r");
+  }
+  if (fp == NULL || fgets(line, sizeof(line), fp) == NULL) {
+    if (fp != NULL) {
+      fclose(fp);
+    }
+    setNode(mask, 0);
+    return 1;
+  }
+  fclose(fp);
+
+  int count = 0;
+  char *ptr = line;
+
+  while (*ptr != '\0' && *ptr != '\n') {
+    char *end;
+    long first = strtol(ptr, &end, 10);
+    long last  = first;
+
+    if (*end == '-') {
+      last = strtol(end + 1, &end, 10);
+    }
+    for (long n = first; n <= last && n < MAXNODES; n++) {
+      setNode(mask, (int)n);
+      count++;
+    }
+    ptr = (*end == ',') ? end + 1 : end;
+  }
+
+  return count;
+}
+
+static int getCurrentNode(void)
+{
+  unsigned int cpu, node;
+
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+    return 0;
+  }
+  return (int)node;
+}
+
+size_t numa_getAlignment(const size_t alignment)
+{
+  if (placement == FIRSTTOUCH) {
+    return alignment;
+  }
+
+  /* mbind operates on whole pages */
+  const size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+  return MAX(alignment, pagesize);
+}
+
+void numa_setPlacement(void *ptr, const size_t bytesize)
+{
+  unsigned long mask[MASKWORDS]  = { 0 };
+  unsigned long avail[MASKWORDS] = { 0 };
+  int mode                       = MPOL_BIND;
+
+  readNodeList(avail);
+
+  switch (placement) {
+  case LOCAL:
+    setNode(mask, getCurrentNode());
+    break;
+  case NODE:
+    if (placement_node >= MAXNODES || !isNodeSet(avail, placement_node)) {
+      fprintf(stderr, "Error: NUMA node %d has no memory\n", placement_node);
+      exit(EXIT_FAILURE);
+    }
+    setNode(mask, placement_node);
+    break;
+  case INTERLEAVE:
+    memcpy(mask, avail, sizeof(mask));
+    mode = MPOL_INTERLEAVE;
+    break;
+  default:
+    return;
+  }
+
+  if (syscall(SYS_mbind, ptr, bytesize, mode, mask, MAXNODES + 1, 0) != 0) {
+    fprintf(stderr,
+        "Warning: mbind failed (%s), falling back to first touch placement\n",
+        strerror(errno));
+  }
+}
+
+/* Migrates the pages of a range to the node of the calling thread. Only pages
+ * completely inside the range are moved, so that neighbouring ranges of other
+ * threads are not affected. Returns 0 on success. */
+int numa_moveLocal(void *ptr, const size_t bytesize)
+{
+  unsigned long mask[MASKWORDS] = { 0 };
+  const size_t pagesize         = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t first            = ((size_t)ptr + pagesize - 1) & ~(pagesize - 1);
+  const size_t last             = ((size_t)ptr + bytesize) & ~(pagesize - 1);
+
+  if (last <= first) {
+    return 0;
+  }
+  setNode(mask, getCurrentNode());
+
+  if (syscall(SYS_mbind, first, last - first, MPOL_BIND, mask, MAXNODES + 1, MPOL_MF_MOVE)
+      != 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+void numa_printPlacement(void)
+{
+  unsigned long avail[MASKWORDS] = { 0 };
+  const int numNodes             = readNodeList(avail);
+
+  switch (placement) {
+  case FIRSTTOUCH:
+    printf("Memory placement: first touch (%d NUMA nodes)\n", numNodes);
+    break;
+  case LOCAL:
+    printf("Memory placement: local, bound to node %d\n", getCurrentNode());
+    break;
+  case NODE:
+    printf("Memory placement: bound to node %d\n", placement_node);
+    break;
+  case INTERLEAVE:
+    printf("Memory placement: interleaved across %d NUMA nodes\n", numNodes);
+    break;
+  default:;
+  }
+}
+
+void numa_printPageDistribution(
+    const char *label, const void *ptr, const size_t bytesize)
+{
+  const size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t numPages = (bytesize + pagesize - 1) / pagesize;
+  const size_t count    = MIN(numPages, SAMPLEPAGES);
+  const size_t stride   = numPages / count;
+  const char *base      = (const char *)((size_t)ptr & ~(pagesize - 1));
+  void **pages          = malloc(count * sizeof(void *));
+  int *status           = malloc(count * sizeof(int));
+  size_t nodeCount[MAXNODES];
+  size_t missing = 0;
+
+  memset(nodeCount, 0, sizeof(nodeCount));
+
+  for (size_t i = 0; i < count; i++) {
+    pages[i] = (void *)(base + i * stride * pagesize);
+  }
+
+  /* move_pages with a NULL node list only queries the current location */
+  if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0) != 0) {
+    printf("%s: page distribution not available (%s)\n", label, strerror(errno));
+    free(pages);
+    free(status);
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (status[i] >= 0 && status[i] < MAXNODES) {
+      nodeCount[status[i]]++;
+    } else {
+      missing++;
+    }
+  }
+
+  printf("%s:", label);
+  for (int n = 0; n < MAXNODES; n++) {
+    if (nodeCount[n]) {
+      printf(" node %d %5.1f%%", n, 100.0 * nodeCount[n] / count);
+    }
+  }
+  if (missing) {
+    printf(" unmapped %5.1f%%", 100.0 * missing / count);
+  }
+  printf("\n");
+
+  free(pages);
+  free(status);
+}
+
+#else /*__linux__*/
+
+size_t numa_getAlignment(const size_t alignment)
+{
+  return alignment;
+}
+
+void numa_setPlacement(void *ptr, const size_t bytesize) { }
+
+int numa_moveLocal(void *ptr, const size_t bytesize)
+{
+  return 0;
+}
+
+void numa_printPlacement(void)
+{
+  printf("Memory placement: first touch (NUMA placement not supported)\n");
+}
+
+void numa_printPageDistribution(
+    const char *label, const void *ptr, const size_t bytesize)
+{
+}
+
+#endif /*__linux__*/
@@ -0,0 +1,18 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef NUMA_H
+#define NUMA_H
+#include <stddef.h>
+
+typedef enum { FIRSTTOUCH = 0, LOCAL, INTERLEAVE, NODE, NUMPLACEMENTS } placements;
+
+extern int numa_parsePlacement(const char *arg);
+extern size_t numa_getAlignment(size_t alignment);
+extern void numa_setPlacement(void *ptr, size_t bytesize);
+extern int numa_moveLocal(void *ptr, size_t bytesize);
+extern void numa_printPlacement(void);
+extern void numa_printPageDistribution(const char *label, const void *ptr, size_t bytesize);
+
+#endif /*NUMA_H*/
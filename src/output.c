@@ -0,0 +1,300 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "affinity.h"
+#include "buildinfo.h"
+#include "cli.h"
+#include "isa.h"
+#include "output.h"
+
+static const char *typeNames[NUMTYPES] = {
+  "ws",
+  "tp",
+  "seq",
+  "loaded",
+  "scaling",
+};
+
+static const char *formatNames[NUMOUTPUTFORMATS] = { "text", "json", "csv" };
+
+// Run metadata, written once in JSON and repeated in every row in CSV
+static const char *metadataKeys[] = { "hostname",
+  "system",
+  "toolchain",
+  "compiler",
+  "flags",
+  "isa",
+  "datatype",
+  "stores",
+  "mode",
+  "pinning",
+  "OMP_PROC_BIND",
+  "OMP_PLACES" };
+
+#define NUMMETADATA (sizeof(metadataKeys) / sizeof(metadataKeys[0]))
+
+static FILE *_file  = NULL;
+static char *_path  = NULL;
+static int _records = 0;
+static int _threads = 1;
+static int *_cpus   = NULL;
+static char _hostname[256];
+static char _system[512];
+
+int output_parseFormat(const char *arg)
+{
+  const char *sep  = strchr(arg, ':');
+  const size_t len = sep ? (size_t)(sep - arg) : strlen(arg);
+
+  for (int i = 0; i < NUMOUTPUTFORMATS; i++) {
+    if (strlen(formatNames[i]) == len && strncmp(arg, formatNames[i], len) == 0) {
+      if (sep != NULL && sep[1] == '\0') {
+        return -1;
+      }
+      output_format = i;
+      _path         = sep ? strdup(sep + 1) : NULL;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+// Writes str quoted and escaped as JSON string or CSV field
+static void writeString(const char *str)
+{
+  fputc('"', _file);
+  for (const char *c = str; *c != '\0'; c++) {
+    if (*c == '"') {
+      fputs(output_format == OUTPUT_JSON ? "\\\"" : "\"\"", _file);
+    } else if (*c == '\\' && output_format == OUTPUT_JSON) {
+      fputs("\\\\", _file);
+    } else {
+      fputc(*c, _file);
+    }
+  }
+  fputc('"', _file);
+}
+
+static const char *getEnv(const char *name)
+{
+  const char *value = getenv(name);
+  return value ? value : "";
+}
+
+static const char *getIsaName(void)
+{
+#ifdef _NVCC
+  return "cuda";
+#else
+  return kernel_isa >= 0 ? isa_getName(kernel_isa) : "auto";
+#endif
+}
+
+// Host, threads and the processor each thread is running on
+static void collectMetadata(void)
+{
+  struct utsname name;
+
+  gethostname(_hostname, sizeof(_hostname));
+  _hostname[sizeof(_hostname) - 1] = '\0';
+  _system[0]                       = '\0';
+  if (uname(&name) == 0) {
+    snprintf(_system,
+        sizeof(_system),
+        "%s %s %s",
+        name.sysname,
+        name.release,
+        name.machine);
+  }
+
+#ifdef _OPENMP
+  _threads = omp_get_max_threads();
+#endif
+  _cpus = (int *)malloc(_threads * sizeof(int));
+
+#if defined(_OPENMP) && defined(__linux__)
+#pragma omp parallel
+  {
+    _cpus[omp_get_thread_num()] = affinity_getProcessorId();
+  }
+#else
+  _cpus[0] = -1;
+#endif
+}
+
+static void getMetadata(const char **values)
+{
+  values[0]  = _hostname;
+  values[1]  = _system;
+  values[2]  = BUILD_TOOLCHAIN;
+  values[3]  = BUILD_COMPILER;
+  values[4]  = BUILD_FLAGS;
+  values[5]  = getIsaName();
+  values[6]  = dataTypeNames[data_type];
+  values[7]  = storeModeNames[store_mode];
+  values[8]  = typeNames[type];
+  values[9]  = affinity_getPinExpression();
+  values[10] = getEnv("OMP_PROC_BIND");
+  values[11] = getEnv("OMP_PLACES");
+}
+
+static void writeJsonMetadata(void)
+{
+  const char *values[NUMMETADATA];
+
+  getMetadata(values);
+  fprintf(_file, "{\n  \"metadata\": {\n");
+  for (size_t i = 0; i < NUMMETADATA; i++) {
+    fprintf(_file, "    \"%s\": ", metadataKeys[i]);
+    writeString(values[i]);
+    fprintf(_file, ",\n");
+  }
+  fprintf(_file, "    \"N\": %zu,\n", N);
+  fprintf(_file, "    \"iterations\": %zu,\n", ITERS);
+  fprintf(_file, "    \"threads\": %d,\n", _threads);
+  fprintf(_file, "    \"cpus\": [");
+  for (int i = 0; i < _threads; i++) {
+    fprintf(_file, i ? ", %d" : "%d", _cpus[i]);
+  }
+  fprintf(_file, "]\n  },\n  \"results\": [");
+}
+
+static void writeCsvHeader(void)
+{
+  for (size_t i = 0; i < NUMMETADATA; i++) {
+    fprintf(_file, "%s,", metadataKeys[i]);
+  }
+  fprintf(_file,
+      "threads,cpus,kernel,N,iter,runs,rate_gbs,eff_rate_gbs,gflops,latency_ns,"
+      "avg_s,min_s,max_s,median_s,p5_s,p95_s,stddev_s,cv_percent,ci_gbs\n");
+}
+
+static void writeCsvMetadata(void)
+{
+  const char *values[NUMMETADATA];
+
+  getMetadata(values);
+  for (size_t i = 0; i < NUMMETADATA; i++) {
+    writeString(values[i]);
+    fputc(',', _file);
+  }
+  fprintf(_file, "%d,\"", _threads);
+  for (int i = 0; i < _threads; i++) {
+    fprintf(_file, i ? " %d" : "%d", _cpus[i]);
+  }
+  fprintf(_file, "\",");
+}
+
+/* Opens the result file given with --output, the default name is
+ * bwbench.json or bwbench.csv in the working directory */
+void output_open(void)
+{
+  char filename[32];
+  const char *path = _path;
+
+  if (output_format == OUTPUT_TEXT) {
+    return;
+  }
+
+  if (path == NULL) {
+    snprintf(filename, sizeof(filename), "bwbench.%s", formatNames[output_format]);
+    path = filename;
+  }
+
+  _file = fopen(path, "w");
+  if (_file == NULL) {
+    fprintf(stderr, "Error: Cannot open output file %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  printf("Writing %s results to %s\n", formatNames[output_format], path);
+
+  collectMetadata();
+  _records = 0;
+  if (output_format == OUTPUT_JSON) {
+    writeJsonMetadata();
+  } else {
+    writeCsvHeader();
+  }
+}
+
+void output_write(const outputRecord *record, const stats *s)
+{
+  if (_file == NULL) {
+    return;
+  }
+
+  if (output_format == OUTPUT_JSON) {
+    fprintf(_file, _records ? ",\n    {" : "\n    {");
+    fprintf(_file, "\"kernel\": ");
+    writeString(record->kernel);
+    fprintf(_file,
+        ", \"N\": %zu, \"iter\": %zu, \"runs\": %zu, \"rate_gbs\": %g, "
+        "\"eff_rate_gbs\": %g, \"gflops\": %g, \"latency_ns\": %g, \"avg_s\": %g, "
+        "\"min_s\": %g, \"max_s\": %g, \"median_s\": %g, \"p5_s\": %g, "
+        "\"p95_s\": %g, \"stddev_s\": %g, \"cv_percent\": %g, \"ci_gbs\": %g}",
+        record->N,
+        record->iter,
+        s->count,
+        record->rate,
+        record->effRate,
+        record->flopRate,
+        record->latency,
+        s->avg,
+        s->min,
+        s->max,
+        s->median,
+        s->p5,
+        s->p95,
+        s->stddev,
+        s->cv,
+        record->ci);
+  } else {
+    writeCsvMetadata();
+    writeString(record->kernel);
+    fprintf(_file,
+        ",%zu,%zu,%zu,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g\n",
+        record->N,
+        record->iter,
+        s->count,
+        record->rate,
+        record->effRate,
+        record->flopRate,
+        record->latency,
+        s->avg,
+        s->min,
+        s->max,
+        s->median,
+        s->p5,
+        s->p95,
+        s->stddev,
+        s->cv,
+        record->ci);
+  }
+  _records++;
+}
+
+void output_close(void)
+{
+  if (_file == NULL) {
+    return;
+  }
+
+  if (output_format == OUTPUT_JSON) {
+    fprintf(_file, "\n  ]\n}\n");
+  }
+  fclose(_file);
+  free(_cpus);
+  _file = NULL;
+}
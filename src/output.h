@@ -0,0 +1,31 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef OUTPUT_H
+#define OUTPUT_H
+#include <stddef.h>
+
+#include "profiler.h"
+
+typedef enum { OUTPUT_TEXT = 0, OUTPUT_JSON, OUTPUT_CSV, NUMOUTPUTFORMATS } outputformats;
+
+/* Result of one kernel at one size. Rates are in GB/s and GFlop/s, latency
+ * is in ns and only set for the latency kernel. */
+typedef struct {
+  const char *kernel;
+  size_t N;
+  size_t iter;
+  double rate;
+  double effRate;
+  double flopRate;
+  double ci;
+  double latency;
+} outputRecord;
+
+extern int output_parseFormat(const char *arg);
+extern void output_open(void);
+extern void output_write(const outputRecord *record, const stats *s);
+extern void output_close(void);
+
+#endif /*OUTPUT_H*/
@@ -0,0 +1,525 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "kernels.h"
+#include "perfctr.h"
+#include "profiler.h"
+#include "registry.h"
+#include "timing.h"
+
+#ifdef _OPENMP
+#define THREAD_ID omp_get_thread_num()
+#else
+#define THREAD_ID 0
+#endif
+
+static const char *counterNames[NUMPERFCTRS] = {
+  "cycles",
+  "instructions",
+  "LLC references",
+  "LLC misses",
+  "memory read",
+  "memory write",
+};
+
+// Sums over the measured runs and all threads, NUMPERFCTRS values per kernel
+static double *_counts = NULL;
+static size_t *_runs   = NULL;
+// Cycles and wall time of thread 0 per kernel, summed over the measured runs
+static double *_cycles  = NULL;
+static double *_seconds = NULL;
+static double _start    = 0.0;
+static int _available[NUMPERFCTRS];
+static int _enabled = 0;
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#define NUMCOREEVENTS 4
+#define MAXUNCORE 64
+#define PMU_PATH "/sys/bus/event_source/devices"
+
+static const uint64_t coreEvents[NUMCOREEVENTS] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_REFERENCES,
+  PERF_COUNT_HW_CACHE_MISSES,
+};
+
+// Memory controller events and the counters they contribute to
+static const char *uncoreEvents[] = { "cas_count_read", "cas_count_write" };
+static const int uncoreCounters[] = { PERFCTR_MEM_READ, PERFCTR_MEM_WRITE };
+
+/* System wide event of one memory controller, bytes is the traffic per
+ * counted event */
+typedef struct {
+  int fd;
+  int counter;
+  double bytes;
+} uncoreEvent;
+
+// Core events of every thread, NUMCOREEVENTS descriptors per thread
+static int *_fds      = NULL;
+static int _threads   = 1;
+static int _numUncore = 0;
+static uncoreEvent _uncore[MAXUNCORE];
+
+// Reads the first line of a sysfs file, returns -1 if it does not exist
+static int readLine(const char *path, char *line, const int length)
+{
+  FILE *fp = fopen(path, "r");
+
+  if (fp == NULL) {
+    return -1;
+  }
+  if (fgets(line, length, fp) == NULL) {
+    line[0] = '\0';
+  }
+  fclose(fp);
+  line[strcspn(line, "\n")] = '\0';
+
+  return 0;
+}
+
+static int readPmuFile(const char *pmu, const char *name, char *line, const int length)
+{
+  char path[512];
+
+  snprintf(path, sizeof(path), "%s/%s/%s", PMU_PATH, pmu, name);
+
+  return readLine(path, line, length);
+}
+
+static int openEvent(struct perf_event_attr *attr, const pid_t pid, const int cpu)
+{
+  attr->size        = sizeof(struct perf_event_attr);
+  attr->disabled    = 1;
+  attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return (int)syscall(SYS_perf_event_open, attr, pid, cpu, -1, 0);
+}
+
+// Count of an event, extrapolated if it was multiplexed with other events
+static double readEvent(const int fd)
+{
+  uint64_t values[3];
+
+  if (read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+    return 0.0;
+  }
+
+  return (double)values[0] * (double)values[1] / (double)values[2];
+}
+
+static void resetEvent(const int fd)
+{
+  ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+  ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+/* Translates an event description like "event=0x04,umask=0x03" to the config
+ * of the PMU using its format files, only fields of config are supported */
+static int parseEvent(const char *pmu, const char *description, uint64_t *config)
+{
+  char buffer[256];
+  char format[64];
+  char *save;
+
+  snprintf(buffer, sizeof(buffer), "%s", description);
+  *config = 0;
+
+  for (char *term = strtok_r(buffer, ",", &save); term != NULL;
+       term       = strtok_r(NULL, ",", &save)) {
+    char *value  = strchr(term, '=');
+    uint64_t val = 1;
+    char name[128];
+    int lo;
+
+    if (value != NULL) {
+      *value++ = '\0';
+      val      = strtoull(value, NULL, 0);
+    }
+    snprintf(name, sizeof(name), "format/%s", term);
+    if (readPmuFile(pmu, name, format, sizeof(format)) != 0 ||
+        sscanf(format, "config:%d", &lo) != 1) {
+      return -1;
+    }
+    *config |= val << lo;
+  }
+
+  return 0;
+}
+
+/* Bytes per count of an event from its scale and unit, a CAS event without
+ * them transfers one cache line */
+static double eventBytes(const char *pmu, const char *event)
+{
+  char name[128];
+  char line[64];
+  double scale = 1.0;
+
+  snprintf(name, sizeof(name), "events/%s.scale", event);
+  if (readPmuFile(pmu, name, line, sizeof(line)) != 0) {
+    return CACHELINE_SIZE;
+  }
+  scale = atof(line);
+
+  snprintf(name, sizeof(name), "events/%s.unit", event);
+  if (readPmuFile(pmu, name, line, sizeof(line)) == 0 && strcmp(line, "MiB") == 0) {
+    scale *= 1024.0 * 1024.0;
+  }
+
+  return scale;
+}
+
+/* Opens event on every processor in the cpumask of the PMU. Returns the number
+ * of opened events or -1 if one of them cannot be opened. */
+static int openUncore(const char *pmu, const int index)
+{
+  const char *event = uncoreEvents[index];
+  char name[128];
+  char line[256];
+  uint64_t config;
+  int opened = 0;
+
+  if (readPmuFile(pmu, "type", line, sizeof(line)) != 0) {
+    return 0;
+  }
+  const int pmuType = atoi(line);
+
+  snprintf(name, sizeof(name), "events/%s", event);
+  if (readPmuFile(pmu, name, line, sizeof(line)) != 0) {
+    return 0;
+  }
+  if (parseEvent(pmu, line, &config) != 0 ||
+      readPmuFile(pmu, "cpumask", line, sizeof(line)) != 0) {
+    return -1;
+  }
+
+  for (const char *ptr = line; *ptr != '\0';) {
+    char *end;
+    const long first = strtol(ptr, &end, 10);
+    long last        = first;
+
+    if (end == ptr) {
+      break;
+    }
+    if (*end == '-') {
+      last = strtol(end + 1, &end, 10);
+    }
+    for (long cpu = first; cpu <= last; cpu++) {
+      struct perf_event_attr attr = { 0 };
+
+      if (_numUncore == MAXUNCORE) {
+        return -1;
+      }
+      attr.type   = pmuType;
+      attr.config = config;
+
+      uncoreEvent *e = &_uncore[_numUncore];
+      e->fd          = openEvent(&attr, -1, (int)cpu);
+      e->counter     = uncoreCounters[index];
+      e->bytes       = eventBytes(pmu, event);
+      if (e->fd < 0) {
+        return -1;
+      }
+      _numUncore++;
+      opened++;
+    }
+    ptr = *end == ',' ? end + 1 : end;
+  }
+
+  return opened;
+}
+
+/* The read and write CAS events of all Intel memory controllers. A counter is
+ * only available if the events of all controllers can be opened, which
+ * requires perf_event_paranoid <= 0 or CAP_PERFMON. */
+static void initUncore(void)
+{
+  int found[NUMPERFCTRS]  = { 0 };
+  int failed[NUMPERFCTRS] = { 0 };
+  DIR *dir                = opendir(PMU_PATH);
+  struct dirent *entry;
+
+  if (dir == NULL) {
+    return;
+  }
+
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, "uncore_imc", 10) != 0) {
+      continue;
+    }
+    for (int i = 0; i < 2; i++) {
+      const int opened = openUncore(entry->d_name, i);
+
+      if (opened < 0) {
+        failed[uncoreCounters[i]] = 1;
+      }
+      found[uncoreCounters[i]] += opened > 0;
+    }
+  }
+  closedir(dir);
+
+  for (int i = 0; i < 2; i++) {
+    const int counter   = uncoreCounters[i];
+    _available[counter] = found[counter] > 0 && !failed[counter];
+  }
+
+  // Partially opened counters would undercount the traffic
+  int kept = 0;
+  for (int i = 0; i < _numUncore; i++) {
+    if (_available[_uncore[i].counter]) {
+      _uncore[kept++] = _uncore[i];
+    } else {
+      close(_uncore[i].fd);
+    }
+  }
+  _numUncore = kept;
+}
+
+/* Opens the counters, the core events in every thread of the team the ws
+ * kernels run on. Without all only the cycles are counted for the frequency.
+ * Returns -1 if no counter is accessible. */
+int perfctr_init(const int all)
+{
+#ifdef _OPENMP
+  _threads = omp_get_max_threads();
+#endif
+  _fds = (int *)malloc(_threads * NUMCOREEVENTS * sizeof(int));
+
+  _Pragma("omp parallel")
+  {
+    int *fds = &_fds[THREAD_ID * NUMCOREEVENTS];
+
+    for (int e = 0; e < NUMCOREEVENTS; e++) {
+      struct perf_event_attr attr = { 0 };
+
+      if (!all && e != PERFCTR_CYCLES) {
+        fds[e] = -1;
+        continue;
+      }
+      attr.type           = PERF_TYPE_HARDWARE;
+      attr.config         = coreEvents[e];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      fds[e]              = openEvent(&attr, 0, -1);
+    }
+  }
+
+  // An event is only used if every thread can count it
+  for (int e = 0; e < NUMCOREEVENTS; e++) {
+    _available[e] = 1;
+    for (int t = 0; t < _threads; t++) {
+      _available[e] &= _fds[t * NUMCOREEVENTS + e] >= 0;
+    }
+    for (int t = 0; t < _threads && !_available[e]; t++) {
+      if (_fds[t * NUMCOREEVENTS + e] >= 0) {
+        close(_fds[t * NUMCOREEVENTS + e]);
+        _fds[t * NUMCOREEVENTS + e] = -1;
+      }
+    }
+  }
+  if (all) {
+    initUncore();
+  }
+
+  for (int i = 0; i < NUMPERFCTRS; i++) {
+    _enabled |= _available[i];
+  }
+  if (!_enabled) {
+    perfctr_close();
+    return -1;
+  }
+
+  _counts  = (double *)calloc(numKernels * NUMPERFCTRS, sizeof(double));
+  _runs    = (size_t *)calloc(numKernels, sizeof(size_t));
+  _cycles  = (double *)calloc(numKernels, sizeof(double));
+  _seconds = (double *)calloc(numKernels, sizeof(double));
+
+  return 0;
+}
+
+/* Called by every thread at the start of a run, thread 0 also starts the
+ * memory controller events */
+void perfctr_start(void)
+{
+  if (!_enabled) {
+    return;
+  }
+
+  const int *fds = &_fds[THREAD_ID * NUMCOREEVENTS];
+
+  for (int e = 0; e < NUMCOREEVENTS; e++) {
+    if (fds[e] >= 0) {
+      resetEvent(fds[e]);
+    }
+  }
+  if (THREAD_ID == 0) {
+    for (int i = 0; i < _numUncore; i++) {
+      resetEvent(_uncore[i].fd);
+    }
+    _start = getTimeStamp();
+  }
+}
+
+// Called by every thread at the end of run k of kernel, warm-up runs are dropped
+void perfctr_stop(const int kernel, const size_t k)
+{
+  if (!_enabled) {
+    return;
+  }
+
+  const int *fds = &_fds[THREAD_ID * NUMCOREEVENTS];
+  double *counts = &_counts[kernel * NUMPERFCTRS];
+  double seconds = 0.0;
+
+  if (THREAD_ID == 0) {
+    seconds = getTimeStamp() - _start;
+    for (int i = 0; i < _numUncore; i++) {
+      ioctl(_uncore[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  for (int e = 0; e < NUMCOREEVENTS; e++) {
+    if (fds[e] >= 0) {
+      ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  if (k < WARMUP_RUNS) {
+    return;
+  }
+
+  for (int e = 0; e < NUMCOREEVENTS; e++) {
+    if (fds[e] >= 0) {
+      const double value = readEvent(fds[e]);
+#pragma omp atomic
+      counts[e] += value;
+      if (e == PERFCTR_CYCLES && THREAD_ID == 0) {
+        _cycles[kernel] += value;
+      }
+    }
+  }
+  if (THREAD_ID == 0) {
+    _seconds[kernel] += seconds;
+    for (int i = 0; i < _numUncore; i++) {
+      counts[_uncore[i].counter] += readEvent(_uncore[i].fd) * _uncore[i].bytes;
+    }
+    _runs[kernel]++;
+  }
+}
+
+void perfctr_close(void)
+{
+  for (int i = 0; _fds != NULL && i < _threads * NUMCOREEVENTS; i++) {
+    if (_fds[i] >= 0) {
+      close(_fds[i]);
+    }
+  }
+  for (int i = 0; i < _numUncore; i++) {
+    close(_uncore[i].fd);
+  }
+  free(_fds);
+  free(_counts);
+  free(_runs);
+  free(_cycles);
+  free(_seconds);
+  _fds       = NULL;
+  _counts    = NULL;
+  _runs      = NULL;
+  _cycles    = NULL;
+  _seconds   = NULL;
+  _numUncore = 0;
+  _enabled   = 0;
+}
+
+#else
+
+int perfctr_init(const int all)
+{
+  return -1;
+}
+
+void perfctr_start(void)
+{
+}
+
+void perfctr_stop(const int kernel, const size_t k)
+{
+}
+
+void perfctr_close(void)
+{
+}
+
+#endif /*__linux__*/
+
+void perfctr_print(void)
+{
+  const char *separator = " ";
+
+  printf("Hardware counters:");
+  for (int i = 0; i < NUMPERFCTRS; i++) {
+    if (_available[i]) {
+      printf("%s%s", separator, counterNames[i]);
+      separator = ", ";
+    }
+  }
+  printf("\n");
+}
+
+int perfctr_isEnabled(void)
+{
+  return _enabled;
+}
+
+int perfctr_isAvailable(const int counter)
+{
+  return _enabled && _available[counter];
+}
+
+// Mean count of a counter per measured run of kernel, in bytes for the memory traffic
+double perfctr_get(const int kernel, const int counter)
+{
+  if (!perfctr_isAvailable(counter) || _runs[kernel] == 0) {
+    return 0.0;
+  }
+
+  return _counts[kernel * NUMPERFCTRS + counter] / (double)_runs[kernel];
+}
+
+// Mean frequency of thread 0 in GHz during the measured runs of kernel
+double perfctr_getFrequency(const int kernel)
+{
+  if (!perfctr_isAvailable(PERFCTR_CYCLES) || _seconds[kernel] <= 0.0) {
+    return 0.0;
+  }
+
+  return 1.0E-09 * _cycles[kernel] / _seconds[kernel];
+}
+
+// Drops the counts of kernel, e.g. before the runs at the next sweep size
+void perfctr_reset(const int kernel)
+{
+  if (!_enabled) {
+    return;
+  }
+
+  memset(&_counts[kernel * NUMPERFCTRS], 0, NUMPERFCTRS * sizeof(double));
+  _runs[kernel]    = 0;
+  _cycles[kernel]  = 0.0;
+  _seconds[kernel] = 0.0;
+}
@@ -0,0 +1,35 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef PERFCTR_H
+#define PERFCTR_H
+#include <stddef.h>
+
+/* Hardware counters measured with perf_event_open around every ws run. The
+ * core events are counted by every thread for itself, the memory traffic by
+ * the read and write CAS events of the memory controllers in bytes. The
+ * effective frequency is given by the cycles of thread 0 and the wall time
+ * between its start and stop. */
+typedef enum {
+  PERFCTR_CYCLES = 0,
+  PERFCTR_INSTRUCTIONS,
+  PERFCTR_LLC_REFERENCES,
+  PERFCTR_LLC_MISSES,
+  PERFCTR_MEM_READ,
+  PERFCTR_MEM_WRITE,
+  NUMPERFCTRS
+} perfctrs;
+
+extern int perfctr_init(int all);
+extern void perfctr_print(void);
+extern void perfctr_start(void);
+extern void perfctr_stop(int kernel, size_t k);
+extern int perfctr_isEnabled(void);
+extern int perfctr_isAvailable(int counter);
+extern double perfctr_get(int kernel, int counter);
+extern double perfctr_getFrequency(int kernel);
+extern void perfctr_reset(int kernel);
+extern void perfctr_close(void);
+
+#endif /*PERFCTR_H*/
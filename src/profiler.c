@@ -2,110 +2,690 @@
  * All rights reserved. This file is part of TheBandwidthBenchmark.
  * Use of this source code is governed by a MIT style
  * license that can be found in the LICENSE file. */
-#include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+#include "affinity.h"
+#include "baseline.h"
 #include "cli.h"
+#include "indices.h"
+#include "kernels.h"
 #include "likwid-marker.h"
+#include "output.h"
+#include "perfctr.h"
 #include "profiler.h"
+#include "stencil.h"
+#include "timing.h"
 #include "util.h"
 
-typedef struct {
-  char *label;
-  size_t words;
-  size_t flops;
-} workType;
-
-// double _t[NUMREGIONS][ITERS];
+// double _t[numKernels][ITERS];
 double **_t;
 FILE *profilerFile                   = NULL;
 char *dat_directory                  = "dat\0";
 
-static workType _regions[NUMREGIONS] = {
-  { "Init",   1, 0 },
-  { "Sum",    1, 1 },
-  { "Copy",   2, 0 },
-  { "Update", 2, 1 },
-  { "Triad",  3, 2 },
-  { "Daxpy",  3, 2 },
-  { "STriad", 4, 2 },
-  { "SDaxpy", 4, 2 }
-};
+// Per thread time stamps of every ws run, the CPU of every thread
+static double *_threadRuns    = NULL;
+static int *_cpus             = NULL;
+static int _threads           = 1;
+static const char *_tracePath = NULL;
+
+// Output of the prefetch distance sweep, kept open next to the file of a seq sweep
+static FILE *_prefetchFile = NULL;
+static int _prefetchKernel = -1;
+
+// Distances of the prefetch sweep, 0 runs the kernel without prefetch
+const size_t prefetchDistances[NUMPREFETCHDISTANCES] = { 0, 64, 128, 256, 512, 1024,
+  2048, 4096 };
+
+
+static size_t getWords(const int j)
+{
+  return _kernels[j].loads + _kernels[j].stores;
+}
+
+/* Words written to arrays which are not read before, the tp kernels write to
+ * a thread private array, hence every store causes a write-allocate there */
+static size_t allocatedWords(const int j)
+{
+  return type == TP ? _kernels[j].stores : _kernels[j].wa;
+}
+
+/* Words actually transferred including write-allocates. With non-temporal
+ * stores there is no write-allocate at all. */
+static size_t effectiveWords(const int j, const size_t bytes)
+{
+  if (useStreamingStores(bytes)) {
+    return getWords(j);
+  }
+
+  return getWords(j) + allocatedWords(j);
+}
+
+/* Useful bytes are the bytes the kernel asks for, transferred bytes the ones
+ * the memory hierarchy has to move: whole cache lines for the strided and
+ * indirect accesses plus write-allocates. Both include the index array of the
+ * gather and scatter kernels. The stencils load their input once or three
+ * times depending on the layer condition in the last level cache. */
+static void getVolume(const int j,
+    const size_t N,
+    const size_t bytesPerWord,
+    const int threads,
+    double *useful,
+    double *transferred)
+{
+  const double indexBytes = (double)N * sizeof(uint32_t);
+  const double lineBytes  = (double)index_getLines() * CACHELINE_SIZE;
+
+  switch (_kernels[j].pattern) {
+  case PATTERN_STRIDED: {
+    const double accesses = (double)(N / STRIDE);
+    const size_t line     = MIN(STRIDE * bytesPerWord, CACHELINE_SIZE);
+
+    *useful      = (double)getWords(j) * bytesPerWord * accesses;
+    *transferred = (double)(getWords(j) + allocatedWords(j)) * line * accesses;
+    break;
+  }
+  case PATTERN_GATHER:
+    *useful      = (double)getWords(j) * bytesPerWord * N + indexBytes;
+    *transferred = (double)(_kernels[j].stores + allocatedWords(j)) * bytesPerWord * N +
+                   indexBytes + _kernels[j].loads * lineBytes;
+    break;
+  case PATTERN_SCATTER:
+    *useful      = (double)getWords(j) * bytesPerWord * N + indexBytes;
+    *transferred = (double)_kernels[j].loads * bytesPerWord * N + indexBytes +
+                   (_kernels[j].stores + allocatedWords(j)) * lineBytes;
+    break;
+  case PATTERN_STENCIL2D:
+  case PATTERN_STENCIL3D: {
+    const int dims    = _kernels[j].pattern == PATTERN_STENCIL2D ? 2 : 3;
+    const int sharing = SEQ ? 1 : MAX(threads, _threads);
+
+    *useful      = (double)getWords(j) * bytesPerWord * N;
+    *transferred = stencil_getBalance(dims, N, bytesPerWord, sharing) * N;
+    break;
+  }
+  default:
+    *useful      = (double)getWords(j) * bytesPerWord * N;
+    *transferred = (double)effectiveWords(j, N * bytesPerWord * threads) *
+                   bytesPerWord * N;
+    break;
+  }
+
+  *useful *= threads;
+  *transferred *= threads;
+}
 
 void profilerInit(void)
 {
   LIKWID_MARKER_INIT;
   _Pragma("omp parallel")
   {
-    LIKWID_MARKER_REGISTER("INIT");
-    LIKWID_MARKER_REGISTER("SUM");
-    LIKWID_MARKER_REGISTER("COPY");
-    LIKWID_MARKER_REGISTER("UPDATE");
-    LIKWID_MARKER_REGISTER("TRIAD");
-    LIKWID_MARKER_REGISTER("DAXPY");
-    LIKWID_MARKER_REGISTER("STRIAD");
-    LIKWID_MARKER_REGISTER("SDAXPY");
+    for (int j = 0; j < numKernels; j++) {
+      if (_kernels[j].ws != NULL) {
+        LIKWID_MARKER_REGISTER(_kernels[j].tag);
+      }
+    }
   }
 }
 
-static void computeStats(double *avgtime, double *maxtime, double *mintime, const int j)
+/* Two-sided 95% quantiles of Student's t distribution for 1 to 30 degrees of
+ * freedom, the normal quantile is used beyond */
+static const double tQuantiles[] = { 12.706,
+  4.303,
+  3.182,
+  2.776,
+  2.571,
+  2.447,
+  2.365,
+  2.306,
+  2.262,
+  2.228,
+  2.201,
+  2.179,
+  2.160,
+  2.145,
+  2.131,
+  2.120,
+  2.110,
+  2.101,
+  2.093,
+  2.086,
+  2.080,
+  2.074,
+  2.069,
+  2.064,
+  2.060,
+  2.056,
+  2.052,
+  2.048,
+  2.045,
+  2.042 };
+
+static int compareDouble(const void *a, const void *b)
+{
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+// Linear interpolation between the closest ranks of the sorted samples
+static double percentile(const double *sorted, const size_t count, const double p)
+{
+  const double rank = p * (double)(count - 1);
+  const size_t lo   = (size_t)rank;
+  const size_t hi   = MIN(lo + 1, count - 1);
+
+  return sorted[lo] + (rank - (double)lo) * (sorted[hi] - sorted[lo]);
+}
+
+/* Statistics of the runs of kernel j, the first run is a warm-up and is not
+ * included. ci is the half-width of the 95% confidence interval of the mean
+ * time, cv the coefficient of variation in percent. */
+static void computeStats(stats *s, const int j, const size_t runs)
 {
-  *avgtime = 0;
-  *maxtime = 0;
-  *mintime = FLT_MAX;
+  const size_t count = runs > WARMUP_RUNS ? runs - WARMUP_RUNS : 0;
+  double *sorted     = (double *)malloc(MAX(count, 1) * sizeof(double));
+  double sum         = 0.0;
+  double sq          = 0.0;
 
-  for (int k = 1; k < ITERS; k++) {
-    *avgtime += _t[j][k];
-    *mintime = MIN(*mintime, _t[j][k]);
-    *maxtime = MAX(*maxtime, _t[j][k]);
+  memset(s, 0, sizeof(stats));
+  s->count = count;
+  if (count == 0) {
+    free(sorted);
+    return;
   }
 
-  *avgtime /= (double)(ITERS - 1);
+  for (size_t k = 0; k < count; k++) {
+    sorted[k] = _t[j][k + WARMUP_RUNS];
+    sum += sorted[k];
+  }
+  qsort(sorted, count, sizeof(double), compareDouble);
+
+  s->avg    = sum / (double)count;
+  s->min    = sorted[0];
+  s->max    = sorted[count - 1];
+  s->median = percentile(sorted, count, 0.5);
+  s->p5     = percentile(sorted, count, 0.05);
+  s->p95    = percentile(sorted, count, 0.95);
+
+  if (count > 1) {
+    const size_t df = count - 1;
+
+    for (size_t k = 0; k < count; k++) {
+      sq += (sorted[k] - s->avg) * (sorted[k] - s->avg);
+    }
+    s->stddev = sqrt(sq / (double)df);
+    s->cv     = 100.0 * s->stddev / s->avg;
+    s->ci     = (df <= 30 ? tQuantiles[df - 1] : 1.96) * s->stddev / sqrt((double)count);
+  }
+
+  free(sorted);
+}
+
+/* Relative half-width of the confidence interval in percent. The bandwidth is
+ * inversely proportional to the time, to first order its relative error
+ * equals the one of the time. */
+static double relativeCI(const stats *s)
+{
+  return s->count > 1 ? 100.0 * s->ci / s->avg : 100.0;
+}
+
+/* Decides if the repetitions of a kernel can stop after runs runs. Without
+ * --ci a fixed number of ITERS runs is done. Otherwise the runs stop as soon
+ * as the confidence interval of all selected kernels, or of kernel j if it is
+ * not negative, is smaller than the target or the time budget since start is
+ * used up. */
+int profilerIsConverged(const int j, const size_t runs, const double start)
+{
+  stats s;
+
+  if (ci_target <= 0.0 || runs < ADAPTIVE_MINRUNS + WARMUP_RUNS) {
+    return 0;
+  }
+  if (getTimeStamp() - start > time_budget) {
+    return 1;
+  }
+
+  for (int i = 0; i < numKernels; i++) {
+    if (j >= 0 && i != j) {
+      continue;
+    }
+    if (j < 0 && (_kernels[i].ws == NULL || !registry_isSelected(i))) {
+      continue;
+    }
+    computeStats(&s, i, runs);
+    if (relativeCI(&s) > ci_target) {
+      return 0;
+    }
+  }
+
+  return 1;
 }
 
 void allocateTimer()
 {
-  _t = malloc(NUMREGIONS * sizeof(double *));
-  for (int i = 0; i < NUMREGIONS; i++)
+  _t = malloc(numKernels * sizeof(double *));
+  for (int i = 0; i < numKernels; i++)
     _t[i] = malloc(ITERS * sizeof(double));
+
+#ifdef _OPENMP
+  _Pragma("omp parallel")
+  {
+    _Pragma("omp single") _threads = omp_get_num_threads();
+  }
+#endif
+  _threadTimes = (threadTime *)calloc(_threads, sizeof(threadTime));
+  _threadRuns  = (double *)calloc(numKernels * ITERS * _threads * 2, sizeof(double));
+  _cpus        = (int *)malloc(_threads * sizeof(int));
+  _cpus[0]     = -1;
+#if defined(_OPENMP) && defined(__linux__)
+  _Pragma("omp parallel")
+  {
+    _cpus[omp_get_thread_num()] = affinity_getProcessorId();
+  }
+#endif
 }
 
 void freeTimer()
 {
-  for (int i = 0; i < NUMREGIONS; i++)
+  for (int i = 0; i < numKernels; i++)
     free(_t[i]);
   free(_t);
+  free(_threadTimes);
+  free(_threadRuns);
+  free(_cpus);
+  perfctr_close();
+}
+
+// Start and end of every thread in run k of kernel j, interleaved
+static double *getThreadRun(const int j, const size_t k)
+{
+  return &_threadRuns[(j * ITERS + k) * _threads * 2];
+}
+
+/* Keeps the time stamps the threads took in the last run of kernel j, called
+ * by PROFILE after every run */
+void profilerRecordThreads(const int j, const size_t k)
+{
+  double *run = getThreadRun(j, k);
+
+  for (int t = 0; t < _threads; t++) {
+    run[2 * t]     = _threadTimes[t].start;
+    run[2 * t + 1] = _threadTimes[t].end;
+  }
+}
+
+void profilerSetTrace(const char *path)
+{
+  _tracePath = path;
+}
+
+/* Mean work time of every thread over the measured runs of kernel j and the
+ * mean time it waits for the slowest thread at the end of the region */
+static void computeThreadTimes(
+    const int j, const size_t runs, double *work, double *wait)
+{
+  const size_t count = runs > WARMUP_RUNS ? runs - WARMUP_RUNS : 1;
+
+  memset(work, 0, _threads * sizeof(double));
+  memset(wait, 0, _threads * sizeof(double));
+
+  for (size_t k = runs - count; k < runs; k++) {
+    const double *run = getThreadRun(j, k);
+    double last       = run[1];
+
+    for (int t = 1; t < _threads; t++) {
+      last = MAX(last, run[2 * t + 1]);
+    }
+    for (int t = 0; t < _threads; t++) {
+      work[t] += (run[2 * t + 1] - run[2 * t]) / (double)count;
+      wait[t] += (last - run[2 * t + 1]) / (double)count;
+    }
+  }
+}
+
+/* Per thread bandwidth of the worksharing kernels. Skew is the difference of
+ * the work time of the slowest and the fastest thread relative to the fastest,
+ * wait the mean time the threads spend in the barrier relative to the mean run
+ * time. The slowest thread is the straggler which limits the bandwidth. */
+static void printThreads(const size_t N)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  double *work              = (double *)malloc(_threads * sizeof(double));
+  double *wait              = (double *)malloc(_threads * sizeof(double));
+  stats s;
+
+  printf(HLINE);
+  printf("Function      Thread min  Thread max  Skew(%%)  Wait(%%)  Slowest thread\n");
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
+    }
+
+    computeStats(&s, j, ITERS);
+    computeThreadTimes(j, ITERS, work, wait);
+    double bytes, effBytes;
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+    int slowest = 0, fastest = 0;
+    double meanWait = 0.0;
+
+    for (int t = 0; t < _threads; t++) {
+      slowest = work[t] > work[slowest] ? t : slowest;
+      fastest = work[t] < work[fastest] ? t : fastest;
+      meanWait += wait[t] / _threads;
+    }
+
+    printf("%-12s%11.2f %11.2f %8.2f %8.2f    %d (CPU %d)\n",
+        _kernels[j].label,
+        1.0E-09 * bytes / _threads / work[slowest],
+        1.0E-09 * bytes / _threads / work[fastest],
+        100.0 * (work[slowest] - work[fastest]) / work[fastest],
+        100.0 * meanWait / s.avg,
+        slowest,
+        _cpus[slowest]);
+  }
+  printf("Bandwidth per thread in GB/s\n");
+
+  free(work);
+  free(wait);
+}
+
+/* Effective frequency of kernel j and the useful bytes per cycle and core at
+ * the bandwidth rate in bytes/s of threads threads */
+static double bytesPerCycle(const int j, const double rate, const int threads)
+{
+  const double ghz = perfctr_getFrequency(j);
+
+  return ghz > 0.0 ? rate / (1.0E09 * ghz * threads) : 0.0;
+}
+
+static void printFrequency(const int j, const double rate, const int threads)
+{
+  if (perfctr_getFrequency(j) > 0.0) {
+    printf("  %8.2f %8.2f\n", perfctr_getFrequency(j), bytesPerCycle(j, rate, threads));
+  } else {
+    printf("  %8s %8s\n", "-", "-");
+  }
+}
+
+/* Frequency columns of the sweep data files, only written if the cycle counter
+ * is available. The latency kernel has no bytes per cycle. */
+static const char *frequencyHeader(const int bytes)
+{
+  if (!perfctr_isAvailable(PERFCTR_CYCLES)) {
+    return "";
+  }
+
+  return bytes ? "  GHz  B/cycle" : "  GHz";
+}
+
+static void writeFrequency(
+    const int j, const double rate, const int threads, const int bytes)
+{
+  const double ghz = perfctr_getFrequency(j);
+
+  if (!perfctr_isAvailable(PERFCTR_CYCLES)) {
+    fputc('\n', profilerFile);
+    return;
+  }
+  if (ghz > 0.0) {
+    fprintf(profilerFile, " %6.2f", ghz);
+  } else {
+    fprintf(profilerFile, " %6s", "-");
+  }
+  if (bytes && ghz > 0.0) {
+    fprintf(profilerFile, " %8.3f", bytesPerCycle(j, rate, threads));
+  } else if (bytes) {
+    fprintf(profilerFile, " %8s", "-");
+  }
+  fputc('\n', profilerFile);
+}
+
+static void printCounter(const int j, const int counter, const double factor)
+{
+  if (perfctr_isAvailable(counter)) {
+    printf(" %12.2f", factor * perfctr_get(j, counter));
+  } else {
+    printf(" %12s", "-");
+  }
+}
+
+/* Measured counts per run next to the data volume of the kernel model. Model
+ * is the transferred volume including write-allocates, LLC miss the volume of
+ * the last level cache misses and Memory the traffic of the memory
+ * controllers. A ratio above one shows traffic the model does not know about,
+ * e.g. from prefetchers or evictions, a ratio below one avoided transfers. */
+static void printCounters(const size_t N)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  const int memory = perfctr_isAvailable(PERFCTR_MEM_READ) &&
+                     perfctr_isAvailable(PERFCTR_MEM_WRITE);
+
+  printf(HLINE);
+  perfctr_print();
+  printf("%-12s %12s %12s %12s %12s %12s %12s\n",
+      "Function",
+      "IPC",
+      "LLC miss(%)",
+      "Model(MB)",
+      "LLC miss(MB)",
+      "Memory(MB)",
+      "Mem./Model");
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
+    }
+
+    double bytes, effBytes;
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+    const double cycles = perfctr_get(j, PERFCTR_CYCLES);
+    const double refs   = perfctr_get(j, PERFCTR_LLC_REFERENCES);
+    const double traffic = perfctr_get(j, PERFCTR_MEM_READ) +
+                           perfctr_get(j, PERFCTR_MEM_WRITE);
+
+    printf("%-12s", _kernels[j].label);
+    if (perfctr_isAvailable(PERFCTR_INSTRUCTIONS) && cycles > 0.0) {
+      printCounter(j, PERFCTR_INSTRUCTIONS, 1.0 / cycles);
+    } else {
+      printf(" %12s", "-");
+    }
+    if (perfctr_isAvailable(PERFCTR_LLC_MISSES) && refs > 0.0) {
+      printCounter(j, PERFCTR_LLC_MISSES, 100.0 / refs);
+    } else {
+      printf(" %12s", "-");
+    }
+    printf(" %12.2f", 1.0E-06 * effBytes);
+    printCounter(j, PERFCTR_LLC_MISSES, 1.0E-06 * CACHELINE_SIZE);
+    if (memory) {
+      printf(" %12.2f %12.2f\n", 1.0E-06 * traffic, traffic / effBytes);
+    } else {
+      printf(" %12s %12s\n", "-", "-");
+    }
+  }
+  printf("Counts per run\n");
+}
+
+static int isStencil(const int j)
+{
+  return _kernels[j].pattern == PATTERN_STENCIL2D ||
+         _kernels[j].pattern == PATTERN_STENCIL3D;
 }
 
-void profilerOpenFile(const int region)
+/* Lattice updates of the stencils against the roofline prediction, which is
+ * the effective Triad bandwidth divided by the bytes per update. LC lists the
+ * caches the layer condition holds in. */
+static void printStencils(const size_t N)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  const int triad           = registry_find("Triad");
+  double roof               = 0.0;
+  stats s;
+
+  if (triad >= 0 && registry_isSelected(triad)) {
+    double bytes, effBytes;
+    computeStats(&s, triad, ITERS);
+    getVolume(triad, N, bytesPerWord, 1, &bytes, &effBytes);
+    roof = effBytes / s.min;
+  }
+
+  printf(HLINE);
+  printf("%-12s %-24s %-10s %8s %11s %11s %11s\n",
+      "Function",
+      "Grid",
+      "LC",
+      "B/LUP",
+      "MLUP/s",
+      "Eff.(GB/s)",
+      "Roofline(%)");
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j) || !isStencil(j)) {
+      continue;
+    }
+
+    const int dims       = _kernels[j].pattern == PATTERN_STENCIL2D ? 2 : 3;
+    const double balance = stencil_getBalance(dims, N, bytesPerWord, _threads);
+    char grid[64], levels[32];
+    double bytes, effBytes;
+
+    computeStats(&s, j, ITERS);
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+    stencil_formatGrid(dims, N, grid, sizeof(grid));
+    stencil_getLevels(dims, N, bytesPerWord, _threads, levels, sizeof(levels));
+
+    printf("%-12s %-24s %-10s %8.1f %11.2f %11.2f",
+        _kernels[j].label,
+        grid,
+        levels,
+        balance,
+        1.0E-06 * N / s.min,
+        1.0E-09 * effBytes / s.min);
+    if (roof > 0.0) {
+      printf(" %11.1f\n", 100.0 * N / s.min / (roof / balance));
+    } else {
+      printf(" %11s\n", "-");
+    }
+  }
+}
+
+/* Writes the work of every thread in every run as timeline in the Chrome trace
+ * event format, which can be viewed in chrome://tracing or Perfetto */
+static void writeTrace(const size_t N)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  FILE *file                = fopen(_tracePath, "w");
+  double origin             = -1.0;
+  int first                 = 1;
+
+  if (file == NULL) {
+    fprintf(stderr, "Error: Cannot open trace file %s\n", _tracePath);
+    return;
+  }
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
+    }
+    for (int t = 0; t < _threads; t++) {
+      const double start = getThreadRun(j, 0)[2 * t];
+      origin             = origin < 0.0 || start < origin ? start : origin;
+    }
+  }
+
+  fprintf(file, "{\n  \"displayTimeUnit\": \"ns\",\n  \"traceEvents\": [");
+  for (int t = 0; t < _threads; t++) {
+    fprintf(file,
+        "%s\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+        "\"tid\": %d, \"args\": {\"name\": \"Thread %d (CPU %d)\"}}",
+        first ? "" : ",",
+        t,
+        t,
+        _cpus[t]);
+    first = 0;
+  }
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
+    }
+
+    double bytes, effBytes;
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+
+    for (size_t k = 0; k < ITERS; k++) {
+      const double *run = getThreadRun(j, k);
+
+      for (int t = 0; t < _threads; t++) {
+        const double duration = run[2 * t + 1] - run[2 * t];
+
+        fprintf(file,
+            ",\n    {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+            "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 0, \"tid\": %d, "
+            "\"args\": {\"run\": %zu, \"rate_gbs\": %g}}",
+            _kernels[j].label,
+            k < WARMUP_RUNS ? "warmup" : "run",
+            1.0E06 * (run[2 * t] - origin),
+            1.0E06 * duration,
+            t,
+            k,
+            duration > 0.0 ? 1.0E-09 * bytes / _threads / duration : 0.0);
+      }
+    }
+  }
+  fprintf(file, "\n  ]\n}\n");
+  fclose(file);
+
+  printf("Thread timeline written to %s\n", _tracePath);
+}
+
+void profilerOpenFile(const int kernel)
 {
   char filename[40];
-  sprintf(filename, "%s/%s.dat", dat_directory, _regions[region].label);
+  sprintf(filename, "%s/%s.dat", dat_directory, _kernels[kernel].label);
   profilerFile = fopen(filename, "w");
-  if (_regions[region].flops == 0) {
+  if (_kernels[kernel].latency) {
     fprintf(profilerFile,
-        "# %s: %lu words, no flops\n",
-        _regions[region].label,
-        _regions[region].words);
+        "# %s: %lu words, dependent loads on %d byte nodes\n",
+        _kernels[kernel].label,
+        getWords(kernel),
+        CACHELINE_SIZE);
     fprintf(profilerFile,
-        "# N  Bytes(MB)  Rate(GB/s)  Avg time(s)  Min time(s)  Max time(s)\n");
+        "# N  Bytes(MB)  Latency(ns)  Avg time(s)  Min time(s)  Max time(s)  "
+        "Median time(s)  CV(%%)  Runs%s\n",
+        frequencyHeader(0));
+  } else if (_kernels[kernel].flops == 0) {
+    fprintf(profilerFile,
+        "# %s: %lu %s words, no flops\n",
+        _kernels[kernel].label,
+        getWords(kernel),
+        dataTypeNames[data_type]);
+    fprintf(profilerFile,
+        "# N  Bytes(MB)  Rate(GB/s)  Avg time(s)  Min time(s)  Max time(s)  "
+        "Eff.Rate(GB/s)  Median time(s)  CV(%%)  Runs%s\n",
+        frequencyHeader(1));
   } else {
     fprintf(profilerFile,
-        "# %s: %lu words, %lu flops\n",
-        _regions[region].label,
-        _regions[region].words,
-        _regions[region].words);
+        "# %s: %lu %s words, %lu flops\n",
+        _kernels[kernel].label,
+        getWords(kernel),
+        dataTypeNames[data_type],
+        _kernels[kernel].flops);
     fprintf(profilerFile,
         "# N  Bytes(MB)  Rate(GB/s)  Rate(GFlop/s)  Avg time(s)  Min time(s)  "
-        "Max time(s)\n");
+        "Max time(s)  Eff.Rate(GB/s)  Median time(s)  CV(%%)  Runs%s\n",
+        frequencyHeader(1));
   }
 
-  printf("Running kernel %s\n", _regions[region].label);
+  printf("Running kernel %s\n", _kernels[kernel].label);
 }
 
 void profilerCloseFile(void)
@@ -113,10 +693,11 @@ void profilerCloseFile(void)
   fclose(profilerFile);
 }
 
-void profilerPrintLine(const size_t N, const size_t iter, const int j)
+void profilerPrintLine(const size_t N, const size_t iter, const size_t runs, const int j)
 {
-  size_t bytesPerWord = sizeof(double);
-  double avgtime, maxtime, mintime;
+  // The latency kernel uses the memory of N doubles for its chain
+  size_t bytesPerWord = _kernels[j].latency ? sizeof(double) : dataTypeSizes[data_type];
+  stats s;
 
   int num_threads = 1;
 
@@ -129,78 +710,382 @@ void profilerPrintLine(const size_t N, const size_t iter, const int j)
   }
 #endif
 
-  computeStats(&avgtime, &maxtime, &mintime, j);
-  double bytes = (double)_regions[j].words * sizeof(double) * N * num_threads;
-  double flops = (double)_regions[j].flops * N * iter * num_threads;
+  computeStats(&s, j, runs);
+  double bytes = (double)getWords(j) * bytesPerWord * N * num_threads;
+  double flops = (double)_kernels[j].flops * N * iter * num_threads;
+  double useful, effBytes;
+  getVolume(j, N, bytesPerWord, num_threads, &useful, &effBytes);
+
+  // The confidence interval is the one of the mean bandwidth
+  outputRecord record = { _kernels[j].label, N, iter };
+  if (_kernels[j].latency) {
+    record.latency = 1.0E09 * s.min / ((double)chainLength(N) * iter);
+  } else {
+    record.rate     = 1.0E-09 * useful * iter / s.min;
+    record.effRate  = 1.0E-09 * effBytes * iter / s.min;
+    record.flopRate = 1.0E-09 * flops / s.min;
+    record.ci       = 1.0E-09 * useful * iter / s.avg * s.ci / s.avg;
+  }
+  output_write(&record, &s);
+
+  // N  Bytes(MB)  Latency(ns)  Avg time(s)  Min time(s)  Max time(s)  Median
+  // time(s)  CV(%)  Runs  [GHz]
+  if (_kernels[j].latency) {
+    const double loads = (double)chainLength(N) * iter;
 
+    fprintf(profilerFile,
+        "%lu %11.5f %11.2f %11.4f  %11.4f  %11.4f  %11.4f %7.2f %5lu",
+        N,
+        1.0E-06 * bytes,
+        1.0E09 * s.min / loads,
+        s.avg,
+        s.min,
+        s.max,
+        s.median,
+        s.cv,
+        s.count);
+    writeFrequency(j, 0.0, num_threads, 0);
+  }
   // N  Bytes(MB)  Rate(GB/s)  Rate(MFlop/s)  Avg time(s)  Min time(s)  Max
-  // time(s)
-  if (flops > 0) {
+  // time(s)  Eff.Rate(GB/s)  Median time(s)  CV(%)  Runs  [GHz  B/cycle]
+  else if (flops > 0) {
     fprintf(profilerFile,
-        "%lu %11.5f %11.2f %11.2f %11.4f  %11.4f  %11.4f\n",
+        "%lu %11.5f %11.2f %11.2f %11.4f  %11.4f  %11.4f %11.2f  %11.4f %7.2f %5lu",
         N,
         1.0E-06 * bytes,
-        1.0E-09 * bytes * iter / mintime,
-        1.0E-09 * flops / mintime,
-        avgtime,
-        mintime,
-        maxtime);
+        1.0E-09 * useful * iter / s.min,
+        1.0E-09 * flops / s.min,
+        s.avg,
+        s.min,
+        s.max,
+        1.0E-09 * effBytes * iter / s.min,
+        s.median,
+        s.cv,
+        s.count);
+    writeFrequency(j, useful * iter / s.min, num_threads, 1);
   }
-  // N  Bytes(MB)  Rate(GB/s)  Avg time(s)  Min time(s)  Max time(s)
+  // N  Bytes(MB)  Rate(GB/s)  Avg time(s)  Min time(s)  Max time(s)  Eff.Rate(GB/s)
+  // Median time(s)  CV(%)  Runs  [GHz  B/cycle]
   else {
     fprintf(profilerFile,
-        "%lu %11.5f %11.2f %11.4f  %11.4f  %11.4f\n",
+        "%lu %11.5f %11.2f %11.4f  %11.4f  %11.4f %11.2f  %11.4f %7.2f %5lu",
         N,
         1.0E-06 * bytes,
-        1.0E-09 * bytes * iter / mintime,
-        avgtime,
-        mintime,
-        maxtime);
+        1.0E-09 * useful * iter / s.min,
+        s.avg,
+        s.min,
+        s.max,
+        1.0E-09 * effBytes * iter / s.min,
+        s.median,
+        s.cv,
+        s.count);
+    writeFrequency(j, useful * iter / s.min, num_threads, 1);
   }
 }
 
+void profilerOpenLoadedFile(const int kernel, const int workers)
+{
+  char filename[60];
+  sprintf(filename, "%s/LoadedLatency-%s.dat", dat_directory, _kernels[kernel].label);
+  profilerFile = fopen(filename, "w");
+  fprintf(profilerFile,
+      "# Loaded latency: %s load (%lu words) on %d threads\n",
+      _kernels[kernel].label,
+      getWords(kernel),
+      workers);
+  fprintf(profilerFile, "# Delay  Rate(GB/s)  Latency(ns)\n");
+
+  printf(HLINE);
+  printf("Loaded latency with %s load on %d threads\n", _kernels[kernel].label, workers);
+  printf("Delay         Rate(GB/s)  Latency(ns)\n");
+}
+
+void profilerPrintLoadedLine(const size_t delay,
+    const size_t elements,
+    const double time,
+    const size_t loads,
+    const int kernel)
+{
+  const double bytes   = (double)getWords(kernel) * sizeof(double) * elements;
+  const double rate    = 1.0E-09 * bytes / time;
+  const double latency = 1.0E09 * time / loads;
+
+  // Delay  Rate(GB/s)  Latency(ns)
+  if (delay == LOADED_IDLE) {
+    fprintf(profilerFile, "idle %11.2f %11.2f\n", rate, latency);
+    printf("%-12s%11.2f %11.2f\n", "idle", rate, latency);
+  } else {
+    fprintf(profilerFile, "%lu %11.2f %11.2f\n", delay, rate, latency);
+    printf("%-12lu%11.2f %11.2f\n", delay, rate, latency);
+  }
+}
+
+void profilerOpenScalingFile(const size_t N)
+{
+  char filename[40];
+  sprintf(filename, "%s/scaling.dat", dat_directory);
+  profilerFile = fopen(filename, "w");
+  fprintf(profilerFile, "# Thread scaling on %zu elements, bandwidth in GB/s\n", N);
+  fprintf(profilerFile, "# Threads");
+
+  printf(HLINE);
+  printf("Thread scaling, bandwidth in GB/s\n");
+  printf("Threads ");
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws != NULL && registry_isSelected(j)) {
+      fprintf(profilerFile, " %s", _kernels[j].label);
+      printf("%11s", _kernels[j].label);
+    }
+  }
+  fprintf(profilerFile, "\n");
+  printf("\n");
+}
+
+// Bandwidth based on the minimum time of every ws kernel on threads threads
+void profilerPrintScalingLine(const int threads, const size_t N, const size_t runs)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  stats s;
+
+  fprintf(profilerFile, "%d", threads);
+  printf("%-8d", threads);
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
+    }
+
+    computeStats(&s, j, runs);
+    double bytes, effBytes;
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+    fprintf(profilerFile, " %.2f", 1.0E-09 * bytes / s.min);
+    printf("%11.2f", 1.0E-09 * bytes / s.min);
+  }
+  fprintf(profilerFile, "\n");
+  printf("\n");
+  fflush(stdout);
+}
+
+/* The prefetch sweep reports the bandwidth at every distance and the distance
+ * with the highest bandwidth. Without a kernel the rows are the selected ws
+ * kernels on N elements, otherwise the sizes of the seq sweep of that kernel. */
+void profilerOpenPrefetchFile(const int kernel)
+{
+  char filename[60];
+
+  if (kernel < 0) {
+    sprintf(filename, "%s/prefetch.dat", dat_directory);
+  } else {
+    sprintf(filename, "%s/%s-prefetch.dat", dat_directory, _kernels[kernel].label);
+  }
+  _prefetchFile   = fopen(filename, "w");
+  _prefetchKernel = kernel;
+  fprintf(_prefetchFile,
+      "# Software prefetch with hint %s, bandwidth in GB/s per distance in bytes\n",
+      prefetchHintNames[prefetch_hint]);
+  fprintf(_prefetchFile, "# %s", kernel < 0 ? "Kernel" : "N");
+
+  printf(HLINE);
+  printf("Software prefetch distance sweep, hint %s, bandwidth in GB/s\n",
+      prefetchHintNames[prefetch_hint]);
+  if (kernel >= 0) {
+    printf("%s\n", _kernels[kernel].label);
+  }
+  printf("%-11s", kernel < 0 ? "Distance" : "N");
+
+  for (int p = 0; p < NUMPREFETCHDISTANCES; p++) {
+    fprintf(_prefetchFile, " %zu", prefetchDistances[p]);
+    printf("%9zu", prefetchDistances[p]);
+  }
+  fprintf(_prefetchFile, " Best\n");
+  printf("%9s\n", "Best");
+}
+
+void profilerClosePrefetchFile(void)
+{
+  fclose(_prefetchFile);
+  _prefetchFile = NULL;
+}
+
+// Bandwidth of kernel j at every distance from the minimum times of iter iterations
+void profilerPrintPrefetchLine(
+    const int j, const size_t N, const size_t iter, const double *times)
+{
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  double useful, effBytes;
+  int best = 0;
+
+  getVolume(j, N, bytesPerWord, 1, &useful, &effBytes);
+  if (_prefetchKernel < 0) {
+    fprintf(_prefetchFile, "%s", _kernels[j].label);
+    printf("%-11s", _kernels[j].label);
+  } else {
+    fprintf(_prefetchFile, "%zu", N);
+    printf("%-11zu", N);
+  }
+
+  for (int p = 0; p < NUMPREFETCHDISTANCES; p++) {
+    const double rate = 1.0E-09 * useful * iter / times[p];
+
+    best = times[p] < times[best] ? p : best;
+    fprintf(_prefetchFile, " %.2f", rate);
+    printf("%9.2f", rate);
+  }
+  fprintf(_prefetchFile, " %zu\n", prefetchDistances[best]);
+  printf("%9zu\n", prefetchDistances[best]);
+  fflush(stdout);
+}
+
+// Minimum time of the runs of kernel j without the warm-up runs
+double profilerGetMinTime(const int j, const size_t runs)
+{
+  stats s;
+
+  computeStats(&s, j, runs);
+  return s.min;
+}
+
 void profilerPrint(const size_t N)
 {
-  double avgtime, maxtime, mintime;
+  const size_t bytesPerWord = dataTypeSizes[data_type];
+  int noisy                 = 0;
+  int imprecise             = 0;
+  stats s;
 
 #ifdef VERBOSE_DATASIZE
-  size_t bytesPerWord = sizeof(double);
   printf(HLINE);
   printf("Dataset sizes\n");
-  for (int i = 0; i < NUMREGIONS; i++) {
+  for (int i = 0; i < numKernels; i++) {
+    if (_kernels[i].ws == NULL || !registry_isSelected(i)) {
+      continue;
+    }
     printf("%s: %8.2f MB\n",
-        _regions[i].label,
-        _regions[i].words * bytesPerWord * N * 1.0E-06);
+        _kernels[i].label,
+        getWords(i) * bytesPerWord * N * 1.0E-06);
   }
 #endif
 
   printf(HLINE);
-  printf("Function      Rate(GB/s)  Rate(GFlop/s)  Avg time     Min time     "
-         "Max time\n");
+  printf("Data type: %s, stores: %s\n",
+      dataTypeNames[data_type],
+      storeModeNames[store_mode]);
+  printf("Function      Rate(GB/s)  Eff.(GB/s)  Rate(GFlop/s)  Avg time     "
+         "Min time     Max time       GHz  B/cycle\n");
 
-  for (int j = 0; j < NUMREGIONS; j++) {
-    computeStats(&avgtime, &maxtime, &mintime, j);
-    const double bytes = (double)_regions[j].words * sizeof(double) * N;
-    const double flops = (double)_regions[j].flops * N;
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
+    }
+
+    computeStats(&s, j, ITERS);
+    const double flops = (double)_kernels[j].flops * N;
+    double bytes, effBytes;
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
 
     if (flops > 0) {
-      printf("%-12s%11.2f %11.2f %11.4f  %11.4f  %11.4f\n",
-          _regions[j].label,
-          1.0E-09 * bytes / mintime,
-          1.0E-09 * flops / mintime,
-          avgtime,
-          mintime,
-          maxtime);
+      printf("%-12s%11.2f %11.2f %11.2f %11.4f  %11.4f  %11.4f",
+          _kernels[j].label,
+          1.0E-09 * bytes / s.min,
+          1.0E-09 * effBytes / s.min,
+          1.0E-09 * flops / s.min,
+          s.avg,
+          s.min,
+          s.max);
     } else {
-      printf("%-12s%11.2f      -      %11.4f  %11.4f  %11.4f\n",
-          _regions[j].label,
-          1.0E-09 * bytes / mintime,
-          avgtime,
-          mintime,
-          maxtime);
+      printf("%-12s%11.2f %11.2f      -      %11.4f  %11.4f  %11.4f",
+          _kernels[j].label,
+          1.0E-09 * bytes / s.min,
+          1.0E-09 * effBytes / s.min,
+          s.avg,
+          s.min,
+          s.max);
+    }
+    printFrequency(j, bytes / s.min, _threads);
+  }
+
+  // Spread of the runs, CI is the 95% confidence interval of the mean bandwidth
+  printf(HLINE);
+  printf("Function      Median time  P5 time      P95 time     CV(%%)  CI(GB/s)     "
+         "Runs\n");
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+      continue;
     }
+
+    computeStats(&s, j, ITERS);
+    double bytes, effBytes;
+    getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+    const double rate   = 1.0E-09 * bytes / s.avg;
+    outputRecord record = { _kernels[j].label, N, 1 };
+    record.rate         = 1.0E-09 * bytes / s.min;
+    record.effRate      = 1.0E-09 * effBytes / s.min;
+    record.flopRate     = 1.0E-09 * _kernels[j].flops * N / s.min;
+    record.ci           = rate * s.ci / s.avg;
+    output_write(&record, &s);
+
+    printf("%-12s%11.4f  %11.4f  %11.4f  %6.2f  +-%-9.2f %5lu%s\n",
+        _kernels[j].label,
+        s.median,
+        s.p5,
+        s.p95,
+        s.cv,
+        rate * s.ci / s.avg,
+        s.count,
+        s.cv > NOISE_CV ? "  noisy" : "");
+
+    noisy |= s.cv > NOISE_CV;
+    imprecise |= ci_target > 0.0 && relativeCI(&s) > ci_target;
   }
   printf(HLINE);
 
+  if (ci_target > 0.0) {
+    printf("Repeated %lu times, confidence interval target +-%.2f%%\n",
+        ITERS,
+        ci_target);
+  }
+  if (imprecise) {
+    printf("Warning: Confidence interval not reached within %.0f s\n", time_budget);
+  }
+  if (noisy) {
+    printf("Warning: Variation above %.0f%%, the results are not reliable\n", NOISE_CV);
+  }
+
+  for (int j = 0; j < numKernels; j++) {
+    if (_kernels[j].ws != NULL && registry_isSelected(j) && isStencil(j)) {
+      printStencils(N);
+      break;
+    }
+  }
+  if (_threads > 1) {
+    printThreads(N);
+  }
+  if (perf_counters && perfctr_isEnabled()) {
+    printCounters(N);
+  }
+  if (_tracePath != NULL) {
+    writeTrace(N);
+  }
+
+  // Mean bandwidth against the baseline given with --baseline
+  if (baseline_isLoaded()) {
+    printf(HLINE);
+    baseline_printHeader();
+
+    for (int j = 0; j < numKernels; j++) {
+      if (_kernels[j].ws == NULL || !registry_isSelected(j)) {
+        continue;
+      }
+
+      computeStats(&s, j, ITERS);
+      double bytes, effBytes;
+      getVolume(j, N, bytesPerWord, 1, &bytes, &effBytes);
+      const double rate = 1.0E-09 * bytes / s.avg;
+      baseline_compare(_kernels[j].label, N, rate, rate * s.ci / s.avg);
+    }
+    printf(HLINE);
+  }
+
   LIKWID_MARKER_CLOSE;
 }
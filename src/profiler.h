@@ -6,43 +6,76 @@
 #define __PROFILER_H_
 #include <stddef.h>
 
+#include "perfctr.h"
+#include "registry.h"
+
+// Runs excluded from the statistics and minimum number of measured runs with --ci
+#define WARMUP_RUNS 1
+#define ADAPTIVE_MINRUNS 5
+// Coefficient of variation in percent above which a kernel is flagged as noisy
+#define NOISE_CV 5.0
+// Number of distances of the software prefetch sweep
+#define NUMPREFETCHDISTANCES 8
+
+/* Statistics of the measured runs of a kernel. Times are in seconds, cv is in
+ * percent and ci is the half-width of the 95% confidence interval of avg. */
+typedef struct {
+  size_t count;
+  double avg;
+  double min;
+  double max;
+  double median;
+  double p5;
+  double p95;
+  double stddev;
+  double cv;
+  double ci;
+} stats;
+
 #ifdef _OPENMP
 #include "likwid-marker.h"
 
-#define PROFILE(tag, call)                                                               \
+#define PROFILE(kernel, call)                                                            \
   _Pragma("omp parallel")                                                                \
   {                                                                                      \
-    LIKWID_MARKER_START(#tag);                                                           \
+    LIKWID_MARKER_START(_kernels[kernel].tag);                                           \
+    perfctr_start();                                                                     \
   }                                                                                      \
-  _t[tag][k] = call;                                                                     \
+  _t[kernel][k] = call;                                                                  \
+  profilerRecordThreads(kernel, k);                                                      \
   _Pragma("omp parallel")                                                                \
   {                                                                                      \
-    LIKWID_MARKER_STOP(#tag);                                                            \
+    perfctr_stop(kernel, k);                                                             \
+    LIKWID_MARKER_STOP(_kernels[kernel].tag);                                            \
   }
 #else
-#define PROFILE(tag, call) _t[tag][k] = call;
+#define PROFILE(kernel, call)                                                            \
+  perfctr_start();                                                                       \
+  _t[kernel][k] = call;                                                                  \
+  perfctr_stop(kernel, k);
 
 #endif
 
-typedef enum {
-  INIT = 0,
-  SUM,
-  COPY,
-  UPDATE,
-  TRIAD,
-  DAXPY,
-  STRIAD,
-  SDAXPY,
-  NUMREGIONS
-} regions;
-
 extern double **_t;
+extern const size_t prefetchDistances[NUMPREFETCHDISTANCES];
 extern void allocateTimer();
 extern void freeTimer();
 extern void profilerInit();
 extern void profilerPrint(size_t size);
-extern void profilerOpenFile(int region);
+extern void profilerRecordThreads(int kernel, size_t k);
+extern void profilerSetTrace(const char *path);
+extern void profilerOpenFile(int kernel);
 extern void profilerCloseFile(void);
-extern void profilerPrintLine(size_t N, size_t iter, int j);
+extern void profilerPrintLine(size_t N, size_t iter, size_t runs, int j);
+extern int profilerIsConverged(int j, size_t runs, double start);
+extern void profilerOpenLoadedFile(int kernel, int workers);
+extern void profilerOpenScalingFile(size_t N);
+extern void profilerPrintScalingLine(int threads, size_t N, size_t runs);
+extern void profilerPrintLoadedLine(
+    size_t delay, size_t elements, double time, size_t loads, int kernel);
+extern void profilerOpenPrefetchFile(int kernel);
+extern void profilerClosePrefetchFile(void);
+extern void profilerPrintPrefetchLine(int j, size_t N, size_t iter, const double *times);
+extern double profilerGetMinTime(int j, size_t runs);
 
 #endif // __PROFILER_H
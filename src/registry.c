@@ -0,0 +1,326 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "cli.h"
+#include "indices.h"
+#include "kernels.h"
+#include "registry.h"
+#include "stencil.h"
+#include "streams.h"
+
+#define WS_PARAMS                                                                        \
+  double *restrict a, double *restrict b, double *restrict c, double *restrict d,        \
+      const double scalar, const size_t N
+#define MODEL_PARAMS(T) T *a, T *b, T *c, T *d, const T scalar
+
+// Arrays and arguments of the worksharing kernels in the order of the ws run
+static double wsInit(WS_PARAMS)
+{
+  return init(b, scalar, N);
+}
+
+static double wsSum(WS_PARAMS)
+{
+#ifdef _NVCC
+  return sum(a, N);
+#else
+  // The persistent variant does not store its result to a
+  if (persistent) {
+    return sum(a, N);
+  }
+
+  // The result is stored to element 10 in the element type
+  const size_t bytes = dataTypeSizes[data_type];
+  char *result       = (char *)a + 10 * bytes;
+  double tmp;
+
+  memcpy(&tmp, result, bytes);
+  const double time = sum(a, N);
+  memcpy(result, &tmp, bytes);
+  return time;
+#endif
+}
+
+static double wsCopy(WS_PARAMS)
+{
+  return copy(c, a, N);
+}
+
+static double wsUpdate(WS_PARAMS)
+{
+  return update(a, scalar, N);
+}
+
+static double wsTriad(WS_PARAMS)
+{
+  return triad(a, b, c, scalar, N);
+}
+
+static double wsDaxpy(WS_PARAMS)
+{
+  return daxpy(a, b, scalar, N);
+}
+
+static double wsStriad(WS_PARAMS)
+{
+  return striad(a, b, c, d, N);
+}
+
+static double wsSdaxpy(WS_PARAMS)
+{
+  return sdaxpy(a, b, c, N);
+}
+
+#ifndef _NVCC
+static double wsStrided(WS_PARAMS)
+{
+  return strided(c, a, N, STRIDE);
+}
+
+static double wsGather(WS_PARAMS)
+{
+  return gather(a, b, index_get(), N);
+}
+
+static double wsScatter(WS_PARAMS)
+{
+  return scatter(a, b, index_get(), N);
+}
+
+static double wsStencil2d(WS_PARAMS)
+{
+  return stencil2d(a, b, STENCIL2D_WEIGHT, N);
+}
+
+static double wsStencil3d(WS_PARAMS)
+{
+  return stencil3d(a, b, STENCIL3D_WEIGHT, N);
+}
+
+static double wsStreams(WS_PARAMS)
+{
+  return streams(stream_reads, stream_writes, scalar, N);
+}
+
+static void setupChain(double *a, const size_t N)
+{
+  initChain((node *)a, chainLength(N), 1);
+}
+
+static void setupIndex(double *a, const size_t N)
+{
+  index_setup(N);
+}
+
+static void setupStreams(double *a, const size_t N)
+{
+  streams_setup(N);
+}
+#else
+#define wsStrided NULL
+#define wsGather NULL
+#define wsScatter NULL
+#define wsStencil2d NULL
+#define wsStencil3d NULL
+#define wsStreams NULL
+#define setupChain NULL
+#define setupIndex NULL
+#define setupStreams NULL
+#endif
+
+/* Both variants of a model share the body, the integer models run in uint64_t
+ * and are reduced to the element type by the caller */
+#define MODEL_OF(name, strided, body)                                                    \
+  static void model##name##Fp(MODEL_PARAMS(double))                                      \
+  {                                                                                      \
+    body;                                                                                \
+  }                                                                                      \
+  static void model##name##Integer(MODEL_PARAMS(uint64_t))                               \
+  {                                                                                      \
+    body;                                                                                \
+  }                                                                                      \
+  static const kernelModel model##name = {                                               \
+    model##name##Fp, model##name##Integer, strided                                       \
+  };
+#define MODEL(name, body) MODEL_OF(name, 0, body)
+// The strided kernel only writes every STRIDE-th element of c
+#define STRIDED_MODEL(name, body) MODEL_OF(name, 1, body)
+
+MODEL(Init, *b = scalar)
+MODEL(Copy, *c = *a)
+STRIDED_MODEL(Stride, *c = *a)
+MODEL(Gather, *a = *b)
+// The mean of the neighbours of a uniform input is the input itself
+MODEL(Stencil, *a = *b)
+MODEL(Update, *a = *a * scalar)
+MODEL(Triad, *a = *b + scalar * *c)
+MODEL(Daxpy, *a = *a + scalar * *b)
+MODEL(Striad, *a = *b + *c * *d)
+MODEL(Sdaxpy, *a = *a + *b * *c)
+
+#ifndef _NVCC
+// Adapts the seq and tp variant of a kernel to the common sweep signature
+#define SWEEP(kernel, ...)                                                               \
+  static double kernel##Seq(WS_PARAMS, const size_t iter)                                \
+  {                                                                                      \
+    return kernel##_seq(__VA_ARGS__, iter);                                              \
+  }                                                                                      \
+  static double kernel##Tp(WS_PARAMS, const size_t iter)                                 \
+  {                                                                                      \
+    return kernel##_tp(__VA_ARGS__, iter);                                               \
+  }
+
+SWEEP(init, a, scalar, N)
+SWEEP(sum, a, N)
+SWEEP(copy, a, b, N)
+SWEEP(update, a, scalar, N)
+SWEEP(triad, a, b, c, scalar, N)
+SWEEP(daxpy, a, b, scalar, N)
+SWEEP(striad, a, b, c, d, N)
+SWEEP(sdaxpy, a, b, c, N)
+SWEEP(strided, a, b, N, STRIDE)
+SWEEP(gather, a, b, index_get(), N)
+SWEEP(scatter, a, b, index_get(), N)
+SWEEP(stencil2d, a, b, STENCIL2D_WEIGHT, N)
+SWEEP(stencil3d, a, b, STENCIL3D_WEIGHT, N)
+SWEEP(streams, stream_reads, stream_writes, scalar, N)
+
+static double latencySeq(WS_PARAMS, const size_t iter)
+{
+  return latency_seq(a, N, iter);
+}
+
+static double latencyTp(WS_PARAMS, const size_t iter)
+{
+  return latency_tp(N, iter);
+}
+
+#define SWEEPS(kernel) kernel##Seq, kernel##Tp
+#else
+#define SWEEPS(kernel) NULL, NULL
+#endif
+
+/* Adding a kernel only requires an entry here. The order is the order in which
+ * the kernels are run and reported. The stream counts of Streams are set with
+ * --streams. */
+#define STREAM PATTERN_STREAM, NULL
+kernelDescriptor _kernels[] = {
+  // label      tag          loads stores wa flops latency pattern setup ws model seq tp
+  { "Init",      "INIT",      0, 1, 1, 0, 0, STREAM, wsInit, &modelInit, SWEEPS(init) },
+  { "Sum",       "SUM",       1, 0, 0, 1, 0, STREAM, wsSum, NULL, SWEEPS(sum) },
+  { "Copy",      "COPY",      1, 1, 1, 0, 0, STREAM, wsCopy, &modelCopy, SWEEPS(copy) },
+  { "Stride",    "STRIDE",    1, 1, 1, 0, 0, PATTERN_STRIDED, NULL, wsStrided,
+      &modelStride, SWEEPS(strided) },
+  { "Update",    "UPDATE",    1, 1, 0, 1, 0, STREAM, wsUpdate, &modelUpdate,
+      SWEEPS(update) },
+  { "Triad",     "TRIAD",     2, 1, 1, 2, 0, STREAM, wsTriad, &modelTriad,
+      SWEEPS(triad) },
+  { "Daxpy",     "DAXPY",     2, 1, 0, 2, 0, STREAM, wsDaxpy, &modelDaxpy,
+      SWEEPS(daxpy) },
+  { "STriad",    "STRIAD",    3, 1, 1, 2, 0, STREAM, wsStriad, &modelStriad,
+      SWEEPS(striad) },
+  { "SDaxpy",    "SDAXPY",    3, 1, 0, 2, 0, STREAM, wsSdaxpy, &modelSdaxpy,
+      SWEEPS(sdaxpy) },
+  { "Gather",    "GATHER",    1, 1, 1, 0, 0, PATTERN_GATHER, setupIndex, wsGather,
+      &modelGather, SWEEPS(gather) },
+  { "Scatter",   "SCATTER",   1, 1, 1, 0, 0, PATTERN_SCATTER, setupIndex, wsScatter,
+      &modelGather, SWEEPS(scatter) },
+  { "Stencil2D", "STENCIL2D", 1, 1, 1, 4, 0, PATTERN_STENCIL2D, NULL, wsStencil2d,
+      &modelStencil, SWEEPS(stencil2d) },
+  { "Stencil3D", "STENCIL3D", 1, 1, 1, 6, 0, PATTERN_STENCIL3D, NULL, wsStencil3d,
+      &modelStencil, SWEEPS(stencil3d) },
+  { "Streams",   "STREAMS",   STREAMS_READS, STREAMS_WRITES, STREAMS_WRITES,
+      STREAMS_READS, 0, PATTERN_STREAMS, setupStreams, wsStreams, NULL, SWEEPS(streams) },
+  { "Latency",   "LATENCY",   1, 0, 0, 0, 1, PATTERN_STREAM, setupChain, NULL, NULL,
+      SWEEPS(latency) },
+};
+#undef STREAM
+
+const int numKernels = sizeof(_kernels) / sizeof(_kernels[0]);
+
+// Kernels enabled with -k, see registry_isSelected for the default set
+static int *_selected = NULL;
+
+int registry_find(const char *label)
+{
+  for (int i = 0; i < numKernels; i++) {
+    if (strcasecmp(label, _kernels[i].label) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/* Enables the kernels in the comma separated list, returns -1 if a kernel is
+ * unknown */
+int registry_select(const char *list)
+{
+  char *buffer = strdup(list);
+  int ret      = 0;
+
+  if (_selected == NULL) {
+    _selected = (int *)calloc(numKernels, sizeof(int));
+  }
+
+  for (char *label = strtok(buffer, ","); label != NULL; label = strtok(NULL, ",")) {
+    const int kernel = registry_find(label);
+
+    if (kernel < 0) {
+      ret = -1;
+      break;
+    }
+    _selected[kernel] = 1;
+  }
+
+  free(buffer);
+  return ret;
+}
+
+/* Without a selection only the streaming kernels run. The strided, indirect,
+ * stencil and N-stream kernels are selected with -k or their options. */
+int registry_isSelected(const int kernel)
+{
+  if (_selected == NULL) {
+    return _kernels[kernel].pattern == PATTERN_STREAM;
+  }
+
+  return _selected[kernel];
+}
+
+// Words and flops per element of the N-stream kernel
+void registry_setStreams(const int reads, const int writes)
+{
+  kernelDescriptor *kernel = &_kernels[registry_find("Streams")];
+
+  kernel->loads  = reads;
+  kernel->stores = writes;
+  kernel->wa     = writes;
+  kernel->flops  = reads;
+}
+
+// Kernels with a software prefetch variant, used with --prefetch
+int registry_hasPrefetch(const int kernel)
+{
+  return kernel == registry_find("Sum") || kernel == registry_find("Copy") ||
+         kernel == registry_find("Triad");
+}
+
+/* Bytes per element of the benchmark arrays. The latency chain and the loaded
+ * mode use the arrays as doubles, all other kernels as the data type. */
+size_t registry_getArrayWordSize(void)
+{
+  const int latency = type != WS && type != SCALING &&
+                      registry_isSelected(registry_find("Latency"));
+
+  if (type == LOADED || latency) {
+    return sizeof(double);
+  }
+
+  return dataTypeSizes[data_type];
+}
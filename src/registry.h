@@ -0,0 +1,74 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef REGISTRY_H
+#define REGISTRY_H
+#include <stddef.h>
+#include <stdint.h>
+
+/* All kernels operate on the four benchmark arrays, every kernel picks the
+ * arrays and arguments it requires. */
+typedef double (*wsKernel)(
+    double *a, double *b, double *c, double *d, double scalar, size_t N);
+typedef double (*sweepKernel)(
+    double *a, double *b, double *c, double *d, double scalar, size_t N, size_t iter);
+typedef void (*modelKernel)(double *a, double *b, double *c, double *d, double scalar);
+typedef void (*integerModelKernel)(
+    uint64_t *a, uint64_t *b, uint64_t *c, uint64_t *d, uint64_t scalar);
+
+/* The model of a kernel in floating point and in unsigned integer arithmetic.
+ * A strided model only applies to the every STRIDE-th element the strided
+ * kernel writes. */
+typedef struct {
+  modelKernel fp;
+  integerModelKernel integer;
+  int strided;
+} kernelModel;
+typedef void (*setupKernel)(double *a, size_t N);
+
+/* Access pattern, determines the useful and the transferred data volume */
+typedef enum {
+  PATTERN_STREAM = 0,
+  PATTERN_STRIDED,
+  PATTERN_GATHER,
+  PATTERN_SCATTER,
+  PATTERN_STENCIL2D,
+  PATTERN_STENCIL3D,
+  PATTERN_STREAMS
+} accessPattern;
+
+/* Descriptor of a benchmark kernel. loads and stores are the words accessed
+ * per iteration, wa the words of arrays which are only written and therefore
+ * cause an additional write-allocate transfer. tag names the LIKWID region.
+ * Kernels without a ws function are only part of the seq and tp sweeps, which
+ * are not available in GPU builds. model reproduces the kernel on a single
+ * element for the validation of the ws results. setup is called before a kernel
+ * runs on N elements, e.g. to build the chain of the latency kernel. */
+typedef struct {
+  const char *label;
+  const char *tag;
+  size_t loads;
+  size_t stores;
+  size_t wa;
+  size_t flops;
+  int latency;
+  accessPattern pattern;
+  setupKernel setup;
+  wsKernel ws;
+  const kernelModel *model;
+  sweepKernel seq;
+  sweepKernel tp;
+} kernelDescriptor;
+
+extern kernelDescriptor _kernels[];
+extern const int numKernels;
+
+extern int registry_find(const char *label);
+extern int registry_select(const char *list);
+extern int registry_isSelected(int kernel);
+extern void registry_setStreams(int reads, int writes);
+extern int registry_hasPrefetch(int kernel);
+extern size_t registry_getArrayWordSize(void);
+
+#endif /*REGISTRY_H*/
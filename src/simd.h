@@ -0,0 +1,198 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef SIMD_H
+#define SIMD_H
+
+/* Primitives for the kernel variants instantiated from kernels-simd.h. Every
+ * variant defines a vector type, its width in elements, a function attribute,
+ * the worksharing loop construct and regular as well as non-temporal
+ * (STREAM) stores. The loop construct has no barrier, every thread takes its
+ * end time stamp before it waits at the end of the parallel region. */
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define SIMD_CAT_(a, b) a##b
+#define SIMD_CAT(a, b) SIMD_CAT_(a, b)
+// Second level used for the element type within expansions of SIMD_CAT
+#define SIMD_TYPE_(a, b) a##b
+#define SIMD_TYPE(a, b) SIMD_TYPE_(a, b)
+
+/* Element types selectable with --datatype. The integer types use unsigned
+ * arithmetic, which wraps around instead of overflowing. */
+#define ELEMENT_double double
+#define ELEMENT_float float
+#define ELEMENT_int32 uint32_t
+#define ELEMENT_int64 uint64_t
+
+/* Non-temporal stores for the loops vectorized by the compiler. The elements of
+ * one vector are computed into an aligned buffer, which the compiler keeps in a
+ * register, and written with one streaming store of the widest vector the
+ * compiler flags allow. Storing every element on its own would be limited by
+ * the issue rate of the scalar streaming stores. */
+#if defined(__AVX512F__)
+#define NTVEC_BYTES 64
+#define NTVEC_STREAM(p, v) _mm512_stream_si512((void *)(p), _mm512_load_si512(v))
+#elif defined(__AVX__)
+#define NTVEC_BYTES 32
+#define NTVEC_STREAM(p, v)                                                               \
+  _mm256_stream_si256((__m256i *)(p), _mm256_load_si256((const __m256i *)(v)))
+#elif defined(SIMD_X86)
+#define NTVEC_BYTES 16
+#define NTVEC_STREAM(p, v)                                                               \
+  _mm_stream_si128((__m128i *)(p), _mm_load_si128((const __m128i *)(v)))
+#else
+#define NTVEC_BYTES 16
+#define NTVEC_STREAM(p, v) __builtin_memcpy(p, v, NTVEC_BYTES)
+#endif
+#ifdef SIMD_X86
+#define SIMD_SFENCE() _mm_sfence()
+#else
+#define SIMD_SFENCE()
+#endif
+#define NTVEC_WIDTH(T) (NTVEC_BYTES / sizeof(T))
+
+// Stores value, an expression of the index i, to the aligned vector at x[start]
+#define NTVEC_STORE(T, x, start, value)                                                  \
+  {                                                                                      \
+    T v_[NTVEC_WIDTH(T)] __attribute__((aligned(NTVEC_BYTES)));                          \
+    const size_t s_ = (start);                                                           \
+    _Pragma("omp simd") for (size_t k_ = 0; k_ < NTVEC_WIDTH(T); k_++)                   \
+    {                                                                                    \
+      const size_t i = s_ + k_;                                                          \
+      v_[k_]         = value;                                                            \
+    }                                                                                    \
+    NTVEC_STREAM(&(x)[s_], v_);                                                          \
+  }
+
+/* Stores value to x[from] up to x[to - 1] with non-temporal vector stores. The
+ * elements before the first and after the last vector boundary are stored
+ * regularly. */
+#define NTVEC_LOOP(T, x, from, to, value)                                                \
+  {                                                                                      \
+    const size_t lead_ = (uintptr_t)&(x)[from] % NTVEC_BYTES / sizeof(T);                \
+    size_t p_          = lead_ ? (from) + NTVEC_WIDTH(T) - lead_ : (from);               \
+    p_                 = p_ < (to) ? p_ : (to);                                          \
+    for (size_t i = (from); i < p_; i++) {                                               \
+      (x)[i] = value;                                                                    \
+    }                                                                                    \
+    for (; p_ + NTVEC_WIDTH(T) <= (to); p_ += NTVEC_WIDTH(T)) {                          \
+      NTVEC_STORE(T, x, p_, value)                                                       \
+    }                                                                                    \
+    for (size_t i = p_; i < (to); i++) {                                                 \
+      (x)[i] = value;                                                                    \
+    }                                                                                    \
+  }
+
+/* Worksharing form of NTVEC_LOOP for x[0] up to x[N - 1], the vectors are
+ * distributed in a static schedule without a barrier */
+#define NTVEC_FOR(T, x, N, value)                                                        \
+  {                                                                                      \
+    const size_t lead_   = (uintptr_t)(x) % NTVEC_BYTES / sizeof(T);                     \
+    const size_t blocks_ = ((N) + lead_ + NTVEC_WIDTH(T) - 1) / NTVEC_WIDTH(T);          \
+    _Pragma("omp for schedule(static) nowait") for (size_t b_ = 0; b_ < blocks_; b_++)   \
+    {                                                                                    \
+      const size_t end_   = (b_ + 1) * NTVEC_WIDTH(T) - lead_;                           \
+      const size_t first_ = b_ ? end_ - NTVEC_WIDTH(T) : 0;                              \
+      const size_t last_  = end_ < (N) ? end_ : (N);                                     \
+      if (last_ - first_ == NTVEC_WIDTH(T)) {                                            \
+        NTVEC_STORE(T, x, first_, value)                                                 \
+      } else {                                                                           \
+        for (size_t i = first_; i < last_; i++) {                                        \
+          (x)[i] = value;                                                                \
+        }                                                                                \
+      }                                                                                  \
+    }                                                                                    \
+  }
+
+/* Software prefetch of the cache line at p for reading, into all cache levels
+ * (T0) or with minimal cache pollution (NTA). The hint of the builtin has to
+ * be a constant. */
+#define SIMD_PREFETCH(p, nta)                                                            \
+  ((nta) ? __builtin_prefetch((p), 0, 0) : __builtin_prefetch((p), 0, 3))
+
+// Plain C, vectorization is left to the compiler and its flags. Adding simd
+// clause because ICX compiler does not vectorise the code due to size_t dataype.
+// This is the only variant instantiated for all element types, the type is
+// taken from DTYPE set by the includer.
+#define VEC_compiler SIMD_TYPE(ELEMENT_, DTYPE)
+#define WIDTH_compiler 1
+#define ATTR_compiler
+#define INTRINSICS_compiler 0
+#define LOOP_compiler _Pragma("omp for simd schedule(static) nowait")
+#define SET1_compiler(s) (s)
+#define LOAD_compiler(p) (*(p))
+#define STORE_compiler(p, v) (*(p) = (v))
+#define ADD_compiler(x, y) ((x) + (y))
+#define MUL_compiler(x, y) ((x) * (y))
+#define FMA_compiler(x, y, z) ((x) * (y) + (z))
+#define REDUCE_compiler(v) (v)
+
+#ifdef SIMD_X86
+// Scalar SSE2 instructions operating on one double
+#define VEC_scalar __m128d
+#define WIDTH_scalar 1
+#define ATTR_scalar
+#define INTRINSICS_scalar 1
+#define LOOP_scalar _Pragma("omp for schedule(static) nowait")
+#define SET1_scalar(s) _mm_set_sd(s)
+#define LOAD_scalar(p) _mm_load_sd(p)
+#define STORE_scalar(p, v) _mm_store_sd(p, v)
+#define STREAM_scalar(p, v)                                                              \
+  _mm_stream_si64((long long *)(p), _mm_cvtsi128_si64(_mm_castpd_si128(v)))
+#define ADD_scalar(x, y) _mm_add_sd(x, y)
+#define MUL_scalar(x, y) _mm_mul_sd(x, y)
+#define FMA_scalar(x, y, z) _mm_add_sd(_mm_mul_sd(x, y), z)
+#define REDUCE_scalar(v) _mm_cvtsd_f64(v)
+
+#define VEC_sse2 __m128d
+#define WIDTH_sse2 2
+#define ATTR_sse2
+#define INTRINSICS_sse2 1
+#define LOOP_sse2 _Pragma("omp for schedule(static) nowait")
+#define SET1_sse2(s) _mm_set1_pd(s)
+#define LOAD_sse2(p) _mm_load_pd(p)
+#define STORE_sse2(p, v) _mm_store_pd(p, v)
+#define STREAM_sse2(p, v) _mm_stream_pd(p, v)
+#define ADD_sse2(x, y) _mm_add_pd(x, y)
+#define MUL_sse2(x, y) _mm_mul_pd(x, y)
+#define FMA_sse2(x, y, z) _mm_add_pd(_mm_mul_pd(x, y), z)
+#define REDUCE_sse2(v) _mm_cvtsd_f64(_mm_add_pd(v, _mm_unpackhi_pd(v, v)))
+
+#define VEC_avx2 __m256d
+#define WIDTH_avx2 4
+#define ATTR_avx2 __attribute__((target("avx2,fma")))
+#define INTRINSICS_avx2 1
+#define LOOP_avx2 _Pragma("omp for schedule(static) nowait")
+#define SET1_avx2(s) _mm256_set1_pd(s)
+#define LOAD_avx2(p) _mm256_load_pd(p)
+#define STORE_avx2(p, v) _mm256_store_pd(p, v)
+#define STREAM_avx2(p, v) _mm256_stream_pd(p, v)
+#define ADD_avx2(x, y) _mm256_add_pd(x, y)
+#define MUL_avx2(x, y) _mm256_mul_pd(x, y)
+#define FMA_avx2(x, y, z) _mm256_fmadd_pd(x, y, z)
+#define REDUCE_avx2(v)                                                                   \
+  REDUCE_sse2(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)))
+
+#define VEC_avx512 __m512d
+#define WIDTH_avx512 8
+#define ATTR_avx512 __attribute__((target("avx512f")))
+#define INTRINSICS_avx512 1
+#define LOOP_avx512 _Pragma("omp for schedule(static) nowait")
+#define SET1_avx512(s) _mm512_set1_pd(s)
+#define LOAD_avx512(p) _mm512_load_pd(p)
+#define STORE_avx512(p, v) _mm512_store_pd(p, v)
+#define STREAM_avx512(p, v) _mm512_stream_pd(p, v)
+#define ADD_avx512(x, y) _mm512_add_pd(x, y)
+#define MUL_avx512(x, y) _mm512_mul_pd(x, y)
+#define FMA_avx512(x, y, z) _mm512_fmadd_pd(x, y, z)
+#define REDUCE_avx512(v) _mm512_reduce_add_pd(v)
+#endif /*SIMD_X86*/
+
+#endif /*SIMD_H*/
@@ -0,0 +1,111 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cli.h"
+#include "stencil.h"
+#include "topology.h"
+
+/* Square or cubic grid of N points, or a grid with inner dimension
+ * stencil_inner. The outer dimension takes the remaining points, elements
+ * beyond the grid are copied by the kernels. */
+void stencil_getGrid(const int dims, const size_t N, stencilGrid *grid)
+{
+  if (dims == 2) {
+    size_t nx = stencil_inner > 0 ? stencil_inner : (size_t)sqrt((double)N);
+
+    nx          = MAX(MIN(nx, N / 3), 1);
+    grid->nx    = nx;
+    grid->ny    = N / nx;
+    grid->nz    = 1;
+    grid->block = stencil_block > 0 ? MIN(stencil_block, grid->nx) : grid->nx;
+  } else {
+    size_t nx = stencil_inner > 0 ? stencil_inner : (size_t)cbrt((double)N);
+
+    nx          = MAX(MIN(nx, (size_t)sqrt((double)N / 3)), 1);
+    grid->nx    = nx;
+    grid->ny    = nx;
+    grid->nz    = N / (nx * nx);
+    grid->block = stencil_block > 0 ? MIN(stencil_block, grid->ny) : grid->ny;
+  }
+}
+
+/* The layer condition holds in a cache if the three rows (2D) or layers (3D)
+ * of the input touched by one sweep over the block fit into it. Every input
+ * element is then loaded once from below the cache instead of three times. */
+int stencil_holdsLayerCondition(const int dims,
+    const stencilGrid *grid,
+    const size_t elementBytes,
+    const double capacity)
+{
+  const double layer = (double)grid->block * (dims == 2 ? 1 : grid->nx) * elementBytes;
+
+  return 3.0 * layer * STENCIL_SAFETY <= capacity;
+}
+
+/* Bytes per lattice update transferred from memory, decided by the layer
+ * condition in the last level cache. The output costs a store and a
+ * write-allocate. Without cache information the layer condition is assumed to
+ * hold. */
+double stencil_getBalance(
+    const int dims, const size_t N, const size_t elementBytes, const int threads)
+{
+  const int last = topology_getNumCaches() - 1;
+  stencilGrid grid;
+
+  stencil_getGrid(dims, N, &grid);
+  if (last < 0 || stencil_holdsLayerCondition(
+                      dims, &grid, elementBytes, topology_getCapacity(last, threads))) {
+    return 3.0 * elementBytes;
+  }
+
+  return 5.0 * elementBytes;
+}
+
+// Levels of the caches the layer condition holds in, e.g. "L2 L3"
+void stencil_getLevels(const int dims,
+    const size_t N,
+    const size_t elementBytes,
+    const int threads,
+    char *levels,
+    const int length)
+{
+  stencilGrid grid;
+  int used = 0;
+
+  stencil_getGrid(dims, N, &grid);
+  levels[0] = '\0';
+
+  for (int i = 0; i < topology_getNumCaches(); i++) {
+    if (stencil_holdsLayerCondition(
+            dims, &grid, elementBytes, topology_getCapacity(i, threads))) {
+      used += snprintf(levels + used,
+          MAX(length - used, 0),
+          "%sL%d",
+          used > 0 ? " " : "",
+          topology_getLevel(i));
+    }
+  }
+  if (topology_getNumCaches() == 0) {
+    snprintf(levels, length, "unknown");
+  } else if (used == 0) {
+    snprintf(levels, length, "none");
+  }
+}
+
+// Grid and blocked dimension like "1000x1000 x:250"
+void stencil_formatGrid(const int dims, const size_t N, char *text, const int length)
+{
+  stencilGrid grid;
+
+  stencil_getGrid(dims, N, &grid);
+  if (dims == 2) {
+    snprintf(text, length, "%zux%zu x:%zu", grid.nx, grid.ny, grid.block);
+  } else {
+    snprintf(text, length, "%zux%zux%zu y:%zu", grid.nx, grid.ny, grid.nz, grid.block);
+  }
+}
@@ -0,0 +1,81 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef STENCIL_H
+#define STENCIL_H
+#include <stddef.h>
+
+#include "util.h"
+
+/* The Jacobi stencils interpret the N elements of an array as a 2D grid of
+ * nx * ny or a 3D grid of nx * ny * nz points, x is the inner dimension. With
+ * spatial blocking the loops run over blocks of block points in x (2D) or in
+ * y (3D). */
+typedef struct {
+  size_t nx;
+  size_t ny;
+  size_t nz;
+  size_t block;
+} stencilGrid;
+
+// The stencils compute the mean of the neighbours of a point
+#define STENCIL2D_WEIGHT 0.25
+#define STENCIL3D_WEIGHT (1.0 / 6.0)
+// The layers required for the layer condition may occupy 1 / STENCIL_SAFETY of a cache
+#define STENCIL_SAFETY 2
+
+/* Row y of a 2D grid between x0 and x1. The boundary is copied, hence a
+ * uniform input gives the same output as a copy. */
+#define STENCIL2D_ROW(a, b, w, nx, ny, y, x0, x1)                                        \
+  {                                                                                      \
+    const size_t row = (y) * (nx);                                                       \
+    if ((y) == 0 || (y) == (ny) - 1) {                                                   \
+      for (size_t x = (x0); x < (x1); x++) {                                             \
+        a[row + x] = b[row + x];                                                         \
+      }                                                                                  \
+    } else {                                                                             \
+      const size_t lo = MAX((x0), 1);                                                    \
+      const size_t hi = MIN((x1), (nx) - 1);                                             \
+      if ((x0) == 0) {                                                                   \
+        a[row] = b[row];                                                                 \
+      }                                                                                  \
+      for (size_t x = lo; x < hi; x++) {                                                 \
+        a[row + x] = w * (b[row + x - 1] + b[row + x + 1] + b[row + x - (nx)] +          \
+                             b[row + x + (nx)]);                                         \
+      }                                                                                  \
+      if ((x1) == (nx)) {                                                                \
+        a[row + (nx) - 1] = b[row + (nx) - 1];                                           \
+      }                                                                                  \
+    }                                                                                    \
+  }
+
+// Row y of plane z of a 3D grid, the boundary is copied
+#define STENCIL3D_ROW(a, b, w, nx, ny, nz, y, z)                                         \
+  {                                                                                      \
+    const size_t row   = ((z) * (ny) + (y)) * (nx);                                      \
+    const size_t plane = (nx) * (ny);                                                    \
+    if ((z) == 0 || (z) == (nz) - 1 || (y) == 0 || (y) == (ny) - 1) {                    \
+      for (size_t x = 0; x < (nx); x++) {                                                \
+        a[row + x] = b[row + x];                                                         \
+      }                                                                                  \
+    } else {                                                                             \
+      a[row] = b[row];                                                                   \
+      for (size_t x = 1; x < (nx) - 1; x++) {                                            \
+        a[row + x] = w * (b[row + x - 1] + b[row + x + 1] + b[row + x - (nx)] +          \
+                             b[row + x + (nx)] + b[row + x - plane] +                    \
+                             b[row + x + plane]);                                        \
+      }                                                                                  \
+      a[row + (nx) - 1] = b[row + (nx) - 1];                                             \
+    }                                                                                    \
+  }
+
+extern void stencil_getGrid(int dims, size_t N, stencilGrid *grid);
+extern int stencil_holdsLayerCondition(
+    int dims, const stencilGrid *grid, size_t elementBytes, double capacity);
+extern double stencil_getBalance(int dims, size_t N, size_t elementBytes, int threads);
+extern void stencil_getLevels(
+    int dims, size_t N, size_t elementBytes, int threads, char *levels, int length);
+extern void stencil_formatGrid(int dims, size_t N, char *text, int length);
+
+#endif /*STENCIL_H*/
@@ -0,0 +1,207 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "allocate.h"
+#include "cli.h"
+#include "numa.h"
+#include "registry.h"
+#include "streams.h"
+
+typedef struct {
+  double *in[MAXSTREAMS];
+  double *out[MAXSTREAMS];
+} streamSet;
+
+/* The shared arrays of the ws and seq kernels. In tp mode every thread writes
+ * to its own output arrays instead and, with --private, reads its own input
+ * arrays. */
+static streamSet _shared;
+static streamSet *_private = NULL;
+static int _threads        = 0;
+static size_t _length      = 0;
+
+static int getThreadId(void)
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+static int getNumThreads(void)
+{
+#ifdef _OPENMP
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+/* Parses <reads>[:<writes>] and sets the stream counts of the kernel
+ * descriptor, returns -1 if a count is out of range */
+int streams_parse(const char *arg)
+{
+  char *end;
+  errno            = 0;
+  const long reads = strtol(arg, &end, 10);
+  long writes      = STREAMS_WRITES;
+
+  if (*end == ':') {
+    writes = strtol(end + 1, &end, 10);
+  }
+  if (arg[0] == '\0' || *end != '\0' || errno != 0 || reads < 1 || reads > MAXSTREAMS ||
+      writes < 1 || writes > MAXSTREAMS) {
+    return -1;
+  }
+
+  stream_reads  = (int)reads;
+  stream_writes = (int)writes;
+  registry_setStreams(stream_reads, stream_writes);
+  return 0;
+}
+
+// Sets the elements from to to of x to one in the element type
+#define FILL(T)                                                                          \
+  for (size_t i = from; i < to; i++) {                                                   \
+    ((T *)x)[i] = (T)1;                                                                  \
+  }
+
+static void fill(double *x, const size_t from, const size_t to)
+{
+  switch (data_type) {
+  case DT_FLOAT:
+    FILL(float);
+    break;
+  case DT_INT32:
+    FILL(uint32_t);
+    break;
+  case DT_INT64:
+    FILL(uint64_t);
+    break;
+  default:
+    FILL(double);
+  }
+}
+
+// Arrays hold N elements of the data type
+static double *allocateStream(const size_t N)
+{
+  return (double *)allocate(
+      numa_getAlignment(ARRAY_ALIGNMENT), N * dataTypeSizes[data_type]);
+}
+
+static void freeStreams(void)
+{
+  const size_t bytes = _length * dataTypeSizes[data_type];
+
+  for (int r = 0; r < stream_reads && _length > 0; r++) {
+    deallocate(_shared.in[r], bytes);
+  }
+  for (int w = 0; w < stream_writes && _length > 0 && type != TP; w++) {
+    deallocate(_shared.out[w], bytes);
+  }
+  for (int t = 0; t < _threads; t++) {
+    for (int r = 0; r < stream_reads && private_inputs; r++) {
+      deallocate(_private[t].in[r], bytes);
+    }
+    for (int w = 0; w < stream_writes; w++) {
+      deallocate(_private[t].out[w], bytes);
+    }
+  }
+  free(_private);
+  _private = NULL;
+  _threads = 0;
+}
+
+/* Allocates the arrays of the N-stream kernel for N elements. The shared
+ * arrays follow the placement policy and are first touched in the same static
+ * distribution as the ws kernels use, thread private arrays by their owner. */
+void streams_setup(const size_t N)
+{
+  freeStreams();
+  _length            = N;
+  const size_t bytes = N * dataTypeSizes[data_type];
+
+  for (int r = 0; r < stream_reads; r++) {
+    _shared.in[r] = allocateStream(N);
+    numa_setPlacement(_shared.in[r], allocatedSize(bytes));
+  }
+  for (int w = 0; w < stream_writes && type != TP; w++) {
+    _shared.out[w] = allocateStream(N);
+    numa_setPlacement(_shared.out[w], allocatedSize(bytes));
+  }
+
+#pragma omp parallel
+  {
+    const int threads  = getNumThreads();
+    const size_t chunk = (N + threads - 1) / threads;
+    const size_t from  = MIN(getThreadId() * chunk, N);
+    const size_t to    = MIN(from + chunk, N);
+
+    for (int r = 0; r < stream_reads; r++) {
+      fill(_shared.in[r], from, to);
+    }
+    for (int w = 0; w < stream_writes && type != TP; w++) {
+      fill(_shared.out[w], from, to);
+    }
+  }
+
+  if (type != TP) {
+    return;
+  }
+
+#pragma omp parallel
+  {
+#pragma omp single
+    {
+      _threads = getNumThreads();
+      _private = (streamSet *)calloc(_threads, sizeof(streamSet));
+    }
+
+    streamSet *set = &_private[getThreadId()];
+
+    for (int r = 0; r < stream_reads; r++) {
+      if (private_inputs) {
+        set->in[r] = allocateStream(N);
+        fill(set->in[r], 0, N);
+      } else {
+        set->in[r] = _shared.in[r];
+      }
+    }
+    for (int w = 0; w < stream_writes; w++) {
+      set->out[w] = allocateStream(N);
+      fill(set->out[w], 0, N);
+    }
+  }
+}
+
+// Input arrays of the calling thread
+double *const *streams_getInputs(void)
+{
+  return _private != NULL ? _private[getThreadId()].in : _shared.in;
+}
+
+// Output arrays of the calling thread
+double *const *streams_getOutputs(void)
+{
+  return _private != NULL ? _private[getThreadId()].out : _shared.out;
+}
+
+void streams_print(const size_t N)
+{
+  printf("Streams: %d read and %d write arrays, %.2f MB\n",
+      stream_reads,
+      stream_writes,
+      1.0E-06 * (stream_reads + stream_writes) * N * dataTypeSizes[data_type]);
+}
@@ -0,0 +1,51 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef STREAMS_H
+#define STREAMS_H
+#include <stddef.h>
+
+#include "kernels.h"
+
+/* The N-stream kernel reads stream_reads arrays and writes the scaled sum of
+ * them to stream_writes arrays. Its arrays are allocated in addition to the
+ * four benchmark arrays. */
+#define MAXSTREAMS 16
+#define STREAMS_READS 8
+#define STREAMS_WRITES 1
+
+// Elements of type T in a cache line
+#define STREAMS_LINE(T) (CACHELINE_SIZE / sizeof(T))
+
+/* Elements start to start + count of all streams, count is at most a cache
+ * line of T. The streams advance by one cache line at a time, hence all of
+ * them are active at the same time. */
+#define STREAMS_BLOCK(T, in, out, reads, writes, scalar, start, count)                   \
+  {                                                                                      \
+    T s[STREAMS_LINE(T)];                                                                \
+    const T *restrict first = (const T *)(in)[0] + (start);                              \
+    for (size_t k = 0; k < (count); k++) {                                               \
+      s[k] = first[k];                                                                   \
+    }                                                                                    \
+    for (int r = 1; r < (reads); r++) {                                                  \
+      const T *restrict src = (const T *)(in)[r] + (start);                              \
+      for (size_t k = 0; k < (count); k++) {                                             \
+        s[k] += src[k];                                                                  \
+      }                                                                                  \
+    }                                                                                    \
+    for (int w = 0; w < (writes); w++) {                                                 \
+      T *restrict dst = (T *)(out)[w] + (start);                                         \
+      for (size_t k = 0; k < (count); k++) {                                             \
+        dst[k] = (scalar) * s[k];                                                        \
+      }                                                                                  \
+    }                                                                                    \
+  }
+
+extern int streams_parse(const char *arg);
+extern void streams_setup(size_t N);
+extern double *const *streams_getInputs(void);
+extern double *const *streams_getOutputs(void);
+extern void streams_print(size_t N);
+
+#endif /*STREAMS_H*/
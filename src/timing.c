@@ -4,6 +4,10 @@
  * license that can be found in the LICENSE file. */
 #include <time.h>
 
+#include "timing.h"
+
+threadTime *_threadTimes = NULL;
+
 double getTimeStamp(void)
 {
   struct timespec ts;
@@ -5,6 +5,18 @@
 #ifndef __TIMING_H_
 #define __TIMING_H_
 
+/* Start and end of the work of every thread in the last run of a worksharing
+ * kernel, padded to a cache line to avoid false sharing between the threads.
+ * sum is the partial sum of the thread in the persistent Sum kernel. */
+typedef struct {
+  double start;
+  double end;
+  double sum;
+  double pad[5];
+} threadTime;
+
+extern threadTime *_threadTimes;
+
 extern double getTimeStamp(void);
 extern double getTimeResolution(void);
 
@@ -0,0 +1,228 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "topology.h"
+#include "util.h"
+
+#define MAXCACHES 8
+#define MAXNODES 64
+
+/* Data or unified cache seen by the processor the benchmark starts on. shared
+ * is the number of processors sharing one instance of the cache. */
+typedef struct {
+  int level;
+  size_t size;
+  int shared;
+} cacheInfo;
+
+typedef struct {
+  int id;
+  char cpus[128];
+  size_t memory;
+} nodeInfo;
+
+static cacheInfo _caches[MAXCACHES];
+static nodeInfo _nodes[MAXNODES];
+static int _numCaches = 0;
+static int _numNodes  = 0;
+
+// Reads the first line of a sysfs file, returns -1 if it does not exist
+static int readLine(const char *path, char *line, const int length)
+{
+  FILE *fp = fopen(path, "r");
+
+  if (fp == NULL) {
+    return -1;
+  }
+  if (fgets(line, length, fp) == NULL) {
+    line[0] = '\0';
+  }
+  fclose(fp);
+  line[strcspn(line, "\n")] = '\0';
+
+  return 0;
+}
+
+// Number of processors in a list like "0-3,8-11"
+static int countList(const char *list)
+{
+  const char *ptr = list;
+  int count       = 0;
+
+  while (*ptr != '\0') {
+    char *end;
+    const long first = strtol(ptr, &end, 10);
+    long last        = first;
+
+    if (end == ptr) {
+      break;
+    }
+    if (*end == '-') {
+      last = strtol(end + 1, &end, 10);
+    }
+    count += (int)(last - first + 1);
+    ptr = *end == ',' ? end + 1 : end;
+  }
+
+  return count;
+}
+
+static int readCacheFile(
+    const int cpu, const int index, const char *name, char *line, const int length)
+{
+  char path[128];
+
+  snprintf(path,
+      sizeof(path),
+      "/sys/devices/system/cpu/cpu%d/cache/index%d/%s",
+      cpu,
+      index,
+      name);
+
+  return readLine(path, line, length);
+}
+
+static void readCaches(const int cpu)
+{
+  char line[256];
+
+  for (int index = 0; _numCaches < MAXCACHES; index++) {
+    cacheInfo *cache = &_caches[_numCaches];
+    char unit        = 'K';
+    size_t size;
+
+    if (readCacheFile(cpu, index, "type", line, sizeof(line)) != 0) {
+      break;
+    }
+    if (strcmp(line, "Instruction") == 0) {
+      continue;
+    }
+    if (readCacheFile(cpu, index, "level", line, sizeof(line)) != 0) {
+      continue;
+    }
+    cache->level = atoi(line);
+    if (readCacheFile(cpu, index, "size", line, sizeof(line)) != 0 ||
+        sscanf(line, "%zu%c", &size, &unit) < 1) {
+      continue;
+    }
+    cache->size = size << (unit == 'M' ? 20 : unit == 'G' ? 30 : unit == 'K' ? 10 : 0);
+    if (readCacheFile(cpu, index, "shared_cpu_list", line, sizeof(line)) == 0) {
+      cache->shared = MAX(countList(line), 1);
+    } else {
+      cache->shared = 1;
+    }
+    _numCaches++;
+  }
+}
+
+static void readNodes(void)
+{
+  char path[128];
+  char line[256];
+
+  for (int id = 0; id < 1024 && _numNodes < MAXNODES; id++) {
+    nodeInfo *node = &_nodes[_numNodes];
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+    if (readLine(path, node->cpus, sizeof(node->cpus)) != 0) {
+      continue;
+    }
+    node->id     = id;
+    node->memory = 0;
+
+    // The first line is "Node <id> MemTotal: <size> kB"
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", id);
+    if (readLine(path, line, sizeof(line)) == 0) {
+      char *total = strstr(line, "MemTotal:");
+      if (total != NULL) {
+        node->memory = strtoull(total + strlen("MemTotal:"), NULL, 10) << 10;
+      }
+    }
+    _numNodes++;
+  }
+}
+
+/* Reads the caches of the processor the calling thread runs on and the NUMA
+ * nodes. Without sysfs no caches are known and the sweep uses a constant
+ * growth. */
+void topology_init(void)
+{
+  int cpu = 0;
+#ifdef __linux__
+  cpu = sched_getcpu();
+#endif
+
+  _numCaches = 0;
+  _numNodes  = 0;
+  readCaches(cpu >= 0 ? cpu : 0);
+  readNodes();
+}
+
+void topology_print(void)
+{
+  if (_numCaches == 0) {
+    printf("Cache sizes unknown, sweep points grow by %.1f\n", SWEEP_GROWTH);
+  }
+  for (int i = 0; i < _numCaches; i++) {
+    printf("L%d cache: %8zu kB, shared by %d processors\n",
+        _caches[i].level,
+        _caches[i].size >> 10,
+        _caches[i].shared);
+  }
+  for (int i = 0; i < _numNodes; i++) {
+    printf("NUMA node %d: %8.2f GB, processors %s\n",
+        _nodes[i].id,
+        _nodes[i].memory * 1.0E-09,
+        _nodes[i].cpus);
+  }
+}
+
+int topology_getNumCaches(void)
+{
+  return _numCaches;
+}
+
+int topology_getLevel(const int index)
+{
+  return _caches[index].level;
+}
+
+/* Capacity of a cache per thread, its size divided by the threads sharing it
+ * assuming compact pinning */
+double topology_getCapacity(const int index, const int threads)
+{
+  return (double)_caches[index].size / MIN(_caches[index].shared, threads);
+}
+
+/* Next array size of a sweep after N. elementBytes is the footprint of one
+ * element of all arrays of a kernel. Within SWEEP_WINDOW_LO to SWEEP_WINDOW_HI
+ * times the capacity per thread the sizes grow by SWEEP_DENSE, elsewhere by
+ * SWEEP_SPARSE without skipping a window. */
+size_t topology_nextSize(const size_t N, const size_t elementBytes, const int threads)
+{
+  if (_numCaches == 0) {
+    return MAX((size_t)(N * SWEEP_GROWTH), N + 1);
+  }
+
+  size_t next = (size_t)(N * SWEEP_SPARSE);
+
+  for (int i = 0; i < _numCaches; i++) {
+    const double boundary = topology_getCapacity(i, threads) / elementBytes;
+    const size_t lo       = (size_t)(boundary * SWEEP_WINDOW_LO);
+    const size_t hi       = (size_t)(boundary * SWEEP_WINDOW_HI);
+
+    if (N >= lo && N < hi) {
+      next = MIN(next, (size_t)(N * SWEEP_DENSE));
+    } else if (N < lo) {
+      next = MIN(next, lo);
+    }
+  }
+
+  return MAX(next, N + 1);
+}
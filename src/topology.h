@@ -0,0 +1,25 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of TheBandwidthBenchmark.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+#include <stddef.h>
+
+// Growth of N between two sweep points away from and close to a cache boundary
+#define SWEEP_SPARSE 1.6
+#define SWEEP_DENSE 1.1
+// Growth without cache information, the classic sweep
+#define SWEEP_GROWTH 1.2
+// Range around a cache capacity which is sampled densely, relative to it
+#define SWEEP_WINDOW_LO 0.5
+#define SWEEP_WINDOW_HI 2.0
+
+extern void topology_init(void);
+extern void topology_print(void);
+extern size_t topology_nextSize(size_t N, size_t elementBytes, int threads);
+extern int topology_getNumCaches(void);
+extern int topology_getLevel(int index);
+extern double topology_getCapacity(int index, int threads);
+
+#endif /*TOPOLOGY_H*/